@@ -0,0 +1,1087 @@
+#include "concurrent_search_server.h"
+#include "corpus_generator.h"
+#include "json_writer.h"
+#include "map_search_server.h"
+#include "process_queries.h"
+#include "query_cache.h"
+#include "read_input_functions.h"
+#include "request_queue.h"
+#include "search_server.h"
+#include "sharded_search_server.h"
+#include "string_processing.h"
+#include "thread_pool.h"
+
+#include <tbb/global_control.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <execution>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <malloc.h>
+#include <map>
+#include <new>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+atomic<uint64_t> allocation_count = 0;
+// Bytes held by live operator new blocks, as malloc sized them; the difference across a
+// build is what the built structure costs on the heap.
+atomic<int64_t> live_heap_bytes = 0;
+
+}
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, memory_order_relaxed);
+    if (void* pointer = malloc(size == 0 ? 1 : size)) {
+        live_heap_bytes.fetch_add(malloc_usable_size(pointer), memory_order_relaxed);
+        return pointer;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    live_heap_bytes.fetch_sub(malloc_usable_size(pointer), memory_order_relaxed);
+    free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    live_heap_bytes.fetch_sub(malloc_usable_size(pointer), memory_order_relaxed);
+    free(pointer);
+}
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+struct BenchmarkOptions {
+    CorpusOptions corpus;
+    size_t max_threads = max(1u, thread::hardware_concurrency());
+    size_t cache_capacity = 10000;
+    vector<size_t> batch_sizes = { 1000, 10000, 100000 };
+    double min_seconds = 0.5;
+    size_t churn_rounds = 30;
+    set<string> sections;
+    string output;
+};
+
+struct Corpus {
+    string stop_words;
+    vector<GeneratedDocument> documents;
+    vector<NewDocument> new_documents;
+    vector<string> queries;
+    size_t text_bytes = 0;
+};
+
+template <typename Function>
+double MeasureSeconds(Function function) {
+    const auto start_time = Clock::now();
+    function();
+    return chrono::duration<double>(Clock::now() - start_time).count();
+}
+
+// Heap bytes that the object returned by build keeps alive.
+template <typename Build>
+auto MeasureHeapBytes(Build build, int64_t& heap_bytes) {
+    const int64_t before = live_heap_bytes.load();
+    auto result = build();
+    heap_bytes = live_heap_bytes.load() - before;
+    return result;
+}
+
+size_t GetResidentBytes() {
+    ifstream statm("/proc/self/statm");
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    statm >> total_pages >> resident_pages;
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Result checks that found a difference; any makes the benchmark exit with failure.
+size_t failed_check_count = 0;
+
+void WriteMismatches(JsonWriter& json, string_view key, size_t mismatches) {
+    json.Write(key, mismatches);
+    if (mismatches > 0) {
+        cerr << key << ": "s << mismatches << endl;
+        ++failed_check_count;
+    }
+}
+
+// Number of ranks at which two tops differ in document, relevance or rating; a document
+// missing from one of them counts once.
+size_t CountMismatches(const vector<Document>& expected, const vector<Document>& actual) {
+    size_t mismatches = max(expected.size(), actual.size()) - min(expected.size(), actual.size());
+    for (size_t i = 0; i < min(expected.size(), actual.size()); ++i) {
+        const Document& lhs = expected[i];
+        const Document& rhs = actual[i];
+        mismatches += lhs.id == rhs.id && lhs.relevance == rhs.relevance && lhs.rating == rhs.rating ? 0 : 1;
+    }
+    return mismatches;
+}
+
+void WriteLatencies(JsonWriter& json, string_view key, vector<double> latencies) {
+    json.BeginObject(key);
+    json.Write("count", latencies.size());
+    if (!latencies.empty()) {
+        sort(latencies.begin(), latencies.end());
+        double total = 0.0;
+        for (const double latency : latencies) {
+            total += latency;
+        }
+        const auto percentile = [&latencies](double fraction) {
+            return latencies[min(latencies.size() - 1, static_cast<size_t>(fraction * latencies.size()))] * 1e6;
+        };
+        json.Write("throughput_per_second", latencies.size() / total);
+        json.Write("mean_us", total / latencies.size() * 1e6);
+        json.Write("p50_us", percentile(0.5));
+        json.Write("p99_us", percentile(0.99));
+        json.Write("p999_us", percentile(0.999));
+        json.Write("max_us", latencies.back() * 1e6);
+    }
+    json.EndObject();
+}
+
+// Runs function(query) over the query log until at least min_seconds have passed.
+template <typename Function>
+vector<double> MeasureQueries(const vector<string>& queries, double min_seconds, Function function) {
+    vector<double> latencies;
+    double total = 0.0;
+    for (size_t i = 0; total < min_seconds || i < queries.size(); ++i) {
+        const double seconds = MeasureSeconds([&] {
+            function(queries[i % queries.size()], i);
+        });
+        latencies.push_back(seconds);
+        total += seconds;
+        if (i >= 100 * queries.size()) {
+            break;
+        }
+    }
+    return latencies;
+}
+
+void WriteStageLatencies(JsonWriter& json, string_view key, SearchOperation operation) {
+    static const pair<SearchStage, string_view> stages[] = {
+        { SearchStage::PARSE, "parse" },
+        { SearchStage::TRAVERSAL, "traversal" },
+        { SearchStage::FILTER, "filter" },
+        { SearchStage::TOP_K, "top_k" },
+        { SearchStage::RESULT, "result" },
+    };
+    json.BeginObject(key);
+    for (const auto& [stage, name] : stages) {
+        const LatencySnapshot snapshot = GetLatencySnapshot(operation, stage);
+        json.BeginObject(name);
+        json.Write("count", snapshot.count);
+        json.Write("p50_ns", static_cast<uint64_t>(snapshot.p50.count()));
+        json.Write("p99_ns", static_cast<uint64_t>(snapshot.p99.count()));
+        json.Write("p999_ns", static_cast<uint64_t>(snapshot.p999.count()));
+        json.EndObject();
+    }
+    json.EndObject();
+}
+
+SearchServer BuildServer(const Corpus& corpus) {
+    SearchServer search_server(corpus.stop_words);
+    search_server.AddDocuments(execution::par, corpus.new_documents);
+    return search_server;
+}
+
+void RunCorpus(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus) {
+    json.BeginObject("corpus");
+    json.Write("documents", corpus.documents.size());
+    json.Write("vocabulary", options.corpus.vocabulary_size);
+    json.Write("min_document_length", options.corpus.min_document_length);
+    json.Write("max_document_length", options.corpus.max_document_length);
+    json.Write("zipf_exponent", options.corpus.zipf_exponent);
+    json.Write("stop_word_ratio", options.corpus.stop_word_ratio);
+    json.Write("minus_word_ratio", options.corpus.minus_word_ratio);
+    json.Write("queries", corpus.queries.size());
+    json.Write("distinct_queries", options.corpus.distinct_query_count);
+    json.Write("seed", options.corpus.seed);
+    json.Write("text_bytes", corpus.text_bytes);
+    json.Write("hardware_threads", static_cast<uint64_t>(thread::hardware_concurrency()));
+    json.EndObject();
+}
+
+void RunTokenizer(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus) {
+    size_t bytes = 0;
+    size_t words = 0;
+    double seconds = 0.0;
+    while (seconds < options.min_seconds) {
+        seconds += MeasureSeconds([&] {
+            for (const GeneratedDocument& document : corpus.documents) {
+                WordTokenizer tokenizer(document.text);
+                string_view word;
+                bool is_valid = true;
+                while (tokenizer.Next(word, is_valid)) {
+                    words += is_valid;
+                }
+                bytes += document.text.size();
+            }
+        });
+    }
+
+    json.BeginObject("tokenizer");
+    json.Write("bytes", bytes);
+    json.Write("words", words);
+    json.Write("gigabytes_per_second", bytes / seconds / 1e9);
+    json.Write("words_per_second", words / seconds);
+    json.EndObject();
+}
+
+void RunIngest(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus) {
+    json.BeginObject("ingest");
+
+    const size_t resident_before = GetResidentBytes();
+    SearchServer sequential(corpus.stop_words);
+    const double add_document_seconds = MeasureSeconds([&] {
+        for (const GeneratedDocument& document : corpus.documents) {
+            sequential.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+    });
+    json.Write("add_document_per_second", corpus.documents.size() / add_document_seconds);
+    json.Write("index_memory_bytes", sequential.GetMemoryUsage());
+    json.Write("resident_growth_bytes", GetResidentBytes() - min(GetResidentBytes(), resident_before));
+    json.Write("terms", sequential.GetTermCount());
+
+    {
+        SearchServer batch(corpus.stop_words);
+        const double seconds = MeasureSeconds([&] {
+            batch.AddDocuments(execution::seq, corpus.new_documents);
+        });
+        json.Write("add_documents_seq_per_second", corpus.documents.size() / seconds);
+    }
+    {
+        SearchServer batch(corpus.stop_words);
+        const double seconds = MeasureSeconds([&] {
+            batch.AddDocuments(execution::par, corpus.new_documents);
+        });
+        json.Write("add_documents_par_per_second", corpus.documents.size() / seconds);
+    }
+
+    const string path = "search_server_benchmark_corpus.tsv";
+    {
+        ofstream output(path, ios::binary);
+        static const char* status_names[] = { "ACTUAL", "IRRELEVANT", "BANNED", "REMOVED" };
+        for (const GeneratedDocument& document : corpus.documents) {
+            output << document.id << '\t' << status_names[static_cast<int>(document.status)] << '\t';
+            for (size_t i = 0; i < document.ratings.size(); ++i) {
+                output << (i > 0 ? " " : "") << document.ratings[i];
+            }
+            output << '\t' << document.text << '\n';
+        }
+    }
+    {
+        SearchServer loaded(corpus.stop_words);
+        CorpusLoadResult result;
+        const double seconds = MeasureSeconds([&] {
+            result = LoadDocuments(loaded, path);
+        });
+        json.Write("load_documents_per_second", result.added_count / seconds);
+        json.Write("load_documents_memory_bytes", loaded.GetMemoryUsage());
+    }
+    remove(path.c_str());
+
+    json.EndObject();
+}
+
+void RunFindTopDocuments(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus, const SearchServer& search_server) {
+    json.BeginObject("find_top_documents");
+
+    ResetLatencyHistograms();
+    WriteLatencies(json, "seq_exhaustive", MeasureQueries(corpus.queries, options.min_seconds, [&](const string& query, size_t) {
+        search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL);
+    }));
+    WriteStageLatencies(json, "seq_exhaustive_stages", SearchOperation::FIND_TOP_DOCUMENTS);
+
+    WriteLatencies(json, "seq_max_score", MeasureQueries(corpus.queries, options.min_seconds, [&](const string& query, size_t) {
+        search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, MAX_RESULT_DOCUMENT_COUNT, QueryEvaluation::MAX_SCORE);
+    }));
+    WriteLatencies(json, "par_exhaustive", MeasureQueries(corpus.queries, options.min_seconds, [&](const string& query, size_t) {
+        search_server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL);
+    }));
+    WriteLatencies(json, "par_max_score", MeasureQueries(corpus.queries, options.min_seconds, [&](const string& query, size_t) {
+        search_server.FindTopDocuments(execution::par, query, DocumentStatus::ACTUAL, MAX_RESULT_DOCUMENT_COUNT, QueryEvaluation::MAX_SCORE);
+    }));
+
+    const uint64_t allocations_before = allocation_count.load();
+    for (const string& query : corpus.queries) {
+        search_server.FindTopDocuments(query);
+    }
+    json.Write("allocations_per_query", static_cast<double>(allocation_count.load() - allocations_before) / corpus.queries.size());
+
+    json.EndObject();
+}
+
+void RunMatchDocument(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus, const SearchServer& search_server) {
+    json.BeginObject("match_document");
+    const auto document_id = [&corpus](size_t i) {
+        return corpus.documents[(i * 7919) % corpus.documents.size()].id;
+    };
+
+    ResetLatencyHistograms();
+    WriteLatencies(json, "seq", MeasureQueries(corpus.queries, options.min_seconds, [&](const string& query, size_t i) {
+        search_server.MatchDocument(execution::seq, query, document_id(i));
+    }));
+    WriteStageLatencies(json, "seq_stages", SearchOperation::MATCH_DOCUMENT);
+    WriteLatencies(json, "par", MeasureQueries(corpus.queries, options.min_seconds, [&](const string& query, size_t i) {
+        search_server.MatchDocument(execution::par, query, document_id(i));
+    }));
+
+    const vector<int> document_ids(search_server.begin(), search_server.end());
+    const string& query = corpus.queries.front();
+    const double loop_seconds = MeasureSeconds([&] {
+        for (const int id : document_ids) {
+            search_server.MatchDocument(query, id);
+        }
+    });
+    json.Write("per_document_loop_documents_per_second", document_ids.size() / loop_seconds);
+    const double seq_seconds = MeasureSeconds([&] {
+        search_server.MatchDocuments(execution::seq, query, document_ids);
+    });
+    json.Write("match_documents_seq_documents_per_second", document_ids.size() / seq_seconds);
+    const double par_seconds = MeasureSeconds([&] {
+        search_server.MatchDocuments(execution::par, query, document_ids);
+    });
+    json.Write("match_documents_par_documents_per_second", document_ids.size() / par_seconds);
+    json.EndObject();
+}
+
+void RunProcessQueries(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus, const SearchServer& search_server) {
+    json.BeginArray("process_queries");
+    for (const size_t batch_size : options.batch_sizes) {
+        vector<string> batch(batch_size);
+        for (size_t i = 0; i < batch_size; ++i) {
+            batch[i] = corpus.queries[i % corpus.queries.size()];
+        }
+
+        json.BeginObject();
+        json.Write("batch_size", batch_size);
+        const double loop_seconds = MeasureSeconds([&] {
+            vector<vector<Document>> results(batch.size());
+            transform(execution::par, batch.begin(), batch.end(), results.begin(), [&search_server](const string& query) {
+                return search_server.FindTopDocuments(query);
+            });
+        });
+        json.Write("per_query_par_per_second", batch_size / loop_seconds);
+        const double batch_seconds = MeasureSeconds([&] {
+            ProcessQueries(search_server, batch);
+        });
+        json.Write("process_queries_per_second", batch_size / batch_seconds);
+        const double joined_seconds = MeasureSeconds([&] {
+            ProcessQueriesJoined(search_server, batch);
+        });
+        json.Write("process_queries_joined_per_second", batch_size / joined_seconds);
+        json.EndObject();
+    }
+    json.EndArray();
+}
+
+void RunParallelScaling(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus, const SearchServer& search_server) {
+    json.BeginArray("parallel_scaling");
+    for (size_t threads = 1; threads <= options.max_threads; threads *= 2) {
+        tbb::global_control control(tbb::global_control::max_allowed_parallelism, threads);
+        json.BeginObject();
+        json.Write("threads", threads);
+        WriteLatencies(json, "find_top_documents_par", MeasureQueries(corpus.queries, options.min_seconds, [&](const string& query, size_t) {
+            search_server.FindTopDocuments(execution::par, query);
+        }));
+        const double seconds = MeasureSeconds([&] {
+            ProcessQueries(search_server, corpus.queries);
+        });
+        json.Write("process_queries_per_second", corpus.queries.size() / seconds);
+        json.EndObject();
+    }
+    json.EndArray();
+}
+
+void RunConcurrent(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus) {
+    ConcurrentSearchServer search_server(corpus.stop_words);
+    search_server.AddDocuments(corpus.new_documents);
+    const size_t reader_count = max<size_t>(1, options.max_threads - 1);
+
+    const auto run_readers = [&](bool with_writer) {
+        atomic<bool> is_done = false;
+        vector<vector<double>> latencies(reader_count);
+        thread writer([&] {
+            const int first_id = corpus.documents.back().id + 1;
+            for (size_t i = 0; with_writer && !is_done; ++i) {
+                const GeneratedDocument& document = corpus.documents[i % corpus.documents.size()];
+                search_server.AddDocument(first_id + static_cast<int>(i), document.text, document.status, document.ratings);
+                search_server.RemoveDocument(first_id + static_cast<int>(i));
+            }
+        });
+        vector<thread> readers;
+        for (size_t reader = 0; reader < reader_count; ++reader) {
+            readers.emplace_back([&, reader] {
+                latencies[reader] = MeasureQueries(corpus.queries, options.min_seconds, [&](const string& query, size_t) {
+                    search_server.FindTopDocuments(query);
+                });
+            });
+        }
+        for (thread& reader : readers) {
+            reader.join();
+        }
+        is_done = true;
+        writer.join();
+
+        vector<double> all;
+        for (const auto& reader_latencies : latencies) {
+            all.insert(all.end(), reader_latencies.begin(), reader_latencies.end());
+        }
+        return all;
+    };
+
+    json.BeginObject("concurrent");
+    json.Write("readers", reader_count);
+    WriteLatencies(json, "read_only", run_readers(false));
+    WriteLatencies(json, "with_writer", run_readers(true));
+    json.EndObject();
+}
+
+// Throughput of clients that each run parallel queries, with the TBB backend of
+// std::execution::par and with a ThreadPool; this is where nesting oversubscribes TBB.
+void RunThreadPool(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus, const SearchServer& search_server) {
+    const auto run_clients = [&](size_t client_count, auto find_top_documents) {
+        atomic<size_t> query_count = 0;
+        const double seconds = MeasureSeconds([&] {
+            vector<thread> clients;
+            for (size_t client = 0; client < client_count; ++client) {
+                clients.emplace_back([&, client] {
+                    const auto start_time = Clock::now();
+                    for (size_t i = client; chrono::duration<double>(Clock::now() - start_time).count() < options.min_seconds; ++i) {
+                        find_top_documents(corpus.queries[i % corpus.queries.size()]);
+                        ++query_count;
+                    }
+                });
+            }
+            for (thread& client : clients) {
+                client.join();
+            }
+        });
+        return query_count / seconds;
+    };
+
+    json.BeginObject("thread_pool");
+    for (const bool pin_workers : { false, true }) {
+        ThreadPool pool(options.max_threads, pin_workers);
+        json.BeginObject(pin_workers ? "pinned" : "unpinned");
+        json.Write("workers", pool.GetWorkerCount());
+
+        json.BeginArray("clients");
+        for (size_t client_count = 1; client_count <= 4 * options.max_threads; client_count *= 2) {
+            json.BeginObject();
+            json.Write("clients", client_count);
+            json.Write("tbb_par_queries_per_second", run_clients(client_count, [&](const string& query) {
+                search_server.FindTopDocuments(execution::par, query);
+            }));
+            json.Write("pool_queries_per_second", run_clients(client_count, [&](const string& query) {
+                search_server.FindTopDocuments(pool.GetPolicy(), query);
+            }));
+            json.EndObject();
+        }
+        json.EndArray();
+
+        // Every query of the log is itself run in parallel from inside a parallel loop.
+        vector<vector<Document>> tbb_results(corpus.queries.size());
+        const double tbb_nested_seconds = MeasureSeconds([&] {
+            transform(execution::par, corpus.queries.begin(), corpus.queries.end(), tbb_results.begin(), [&](const string& query) {
+                return search_server.FindTopDocuments(execution::par, query);
+            });
+        });
+        json.Write("nested_tbb_par_queries_per_second", corpus.queries.size() / tbb_nested_seconds);
+        vector<vector<Document>> pool_results(corpus.queries.size());
+        const double pool_nested_seconds = MeasureSeconds([&] {
+            pool.ParallelFor(corpus.queries.size(), [&](size_t i) {
+                pool_results[i] = search_server.FindTopDocuments(pool.GetPolicy(), corpus.queries[i]);
+            });
+        });
+        json.Write("nested_pool_queries_per_second", corpus.queries.size() / pool_nested_seconds);
+        size_t mismatches = 0;
+        for (size_t i = 0; i < corpus.queries.size(); ++i) {
+            mismatches += CountMismatches(tbb_results[i], pool_results[i]);
+        }
+        WriteMismatches(json, "nested_mismatched_documents", mismatches);
+
+        const double tbb_batch_seconds = MeasureSeconds([&] {
+            ProcessQueries(search_server, corpus.queries);
+        });
+        json.Write("process_queries_tbb_par_per_second", corpus.queries.size() / tbb_batch_seconds);
+        const double pool_batch_seconds = MeasureSeconds([&] {
+            ProcessQueries(search_server, corpus.queries, pool);
+        });
+        json.Write("process_queries_pool_per_second", corpus.queries.size() / pool_batch_seconds);
+        json.EndObject();
+    }
+    json.EndObject();
+}
+
+// Tail latency and completeness of queries under a latency budget, synchronous and
+// through the asynchronous API on a ThreadPool.
+void RunDeadlines(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus, const SearchServer& search_server) {
+    static const pair<string_view, chrono::microseconds> budgets[] = {
+        { "unlimited", chrono::microseconds::max() },
+        { "1ms", chrono::microseconds(1000) },
+        { "200us", chrono::microseconds(200) },
+        { "50us", chrono::microseconds(50) },
+    };
+    const auto make_deadline = [](chrono::microseconds budget) {
+        return budget == chrono::microseconds::max() ? QueryDeadline() : QueryDeadline(budget);
+    };
+
+    ThreadPool pool(options.max_threads);
+    json.BeginArray("deadlines");
+    for (const auto& [name, budget] : budgets) {
+        json.BeginObject();
+        json.Write("budget", name);
+        size_t complete_count = 0;
+        const vector<double> latencies = MeasureQueries(corpus.queries, options.min_seconds, [&](const string& query, size_t) {
+            complete_count += search_server.FindTopDocumentsWithin(execution::seq, query, make_deadline(budget)).is_complete ? 1 : 0;
+        });
+        WriteLatencies(json, "seq", latencies);
+        json.Write("seq_complete_ratio", static_cast<double>(complete_count) / latencies.size());
+
+        complete_count = 0;
+        const double async_seconds = MeasureSeconds([&] {
+            vector<future<QueryResult>> results;
+            results.reserve(corpus.queries.size());
+            for (const string& query : corpus.queries) {
+                results.push_back(search_server.FindTopDocumentsAsync(pool, query, make_deadline(budget)));
+            }
+            for (future<QueryResult>& result : results) {
+                complete_count += result.get().is_complete ? 1 : 0;
+            }
+        });
+        json.Write("async_queries_per_second", corpus.queries.size() / async_seconds);
+        json.Write("async_complete_ratio", static_cast<double>(complete_count) / corpus.queries.size());
+        json.EndObject();
+    }
+    json.EndArray();
+}
+
+void RunQueryCache(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus, const SearchServer& search_server) {
+    CorpusOptions query_options = options.corpus;
+    if (query_options.distinct_query_count == 0) {
+        query_options.distinct_query_count = max<size_t>(1, query_options.query_count / 10);
+    }
+    const vector<string> queries = CorpusGenerator(query_options).GenerateQueries();
+
+    QueryCache cache(options.cache_capacity);
+    json.BeginObject("query_cache");
+    json.Write("capacity", options.cache_capacity);
+    json.Write("distinct_queries", query_options.distinct_query_count);
+    WriteLatencies(json, "uncached", MeasureQueries(queries, options.min_seconds, [&](const string& query, size_t) {
+        search_server.FindTopDocuments(query);
+    }));
+    WriteLatencies(json, "cached", MeasureQueries(queries, options.min_seconds, [&](const string& query, size_t) {
+        cache.FindTopDocuments(search_server, query);
+    }));
+    json.Write("hit_rate", cache.GetHitRate());
+    json.Write("entries", cache.GetSize());
+    json.Write("memory_bytes", cache.GetMemoryUsage());
+    json.EndObject();
+}
+
+void RunRequestQueue(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus, const SearchServer& search_server) {
+    json.BeginArray("request_queue");
+    for (size_t threads = 1; threads <= options.max_threads; threads *= 2) {
+        RequestQueue request_queue(search_server);
+        const size_t requests_per_thread = 100000;
+        const double seconds = MeasureSeconds([&] {
+            vector<thread> workers;
+            for (size_t worker = 0; worker < threads; ++worker) {
+                workers.emplace_back([&request_queue, requests_per_thread] {
+                    const string query = "nosuchword"s;
+                    for (size_t i = 0; i < requests_per_thread; ++i) {
+                        request_queue.AddFindRequest(query);
+                    }
+                });
+            }
+            for (thread& worker : workers) {
+                worker.join();
+            }
+        });
+        json.BeginObject();
+        json.Write("threads", threads);
+        json.Write("requests_per_second", threads * requests_per_thread / seconds);
+        json.Write("no_result_requests", request_queue.GetNoResultRequests());
+        // No request has a result, so the whole window counts.
+        const size_t expected = min(threads * requests_per_thread, request_queue.GetWindowSize());
+        WriteMismatches(json, "miscounted_requests", request_queue.GetNoResultRequests() == static_cast<int>(expected) ? 0 : 1);
+        json.EndObject();
+    }
+    json.EndArray();
+}
+
+// The std::map index the server started from, against the current one: heap bytes of
+// the whole server per posting, query latency, and what caching IDF saves on short queries.
+void RunBaseline(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus) {
+    int64_t map_heap_bytes = 0;
+    const MapSearchServer map_server = MeasureHeapBytes([&] {
+        MapSearchServer map_server(corpus.stop_words);
+        for (const GeneratedDocument& document : corpus.documents) {
+            map_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+        return map_server;
+    }, map_heap_bytes);
+    int64_t heap_bytes = 0;
+    const SearchServer search_server = MeasureHeapBytes([&] {
+        SearchServer search_server(corpus.stop_words);
+        for (const GeneratedDocument& document : corpus.documents) {
+            search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+        return search_server;
+    }, heap_bytes);
+    const size_t postings = search_server.GetPostingCount();
+
+    // One or two rare plus words repeated over a small set: the lists are short and the
+    // dictionary stays in cache, so computing IDF is a visible part of each query.
+    map<string_view, int> document_freqs;
+    for (const int document_id : search_server) {
+        search_server.GetWordFrequencies(document_id).ForEachWord([&document_freqs](string_view word, double) {
+            ++document_freqs[word];
+        });
+    }
+    vector<string> short_queries;
+    for (const string& query : corpus.queries) {
+        string short_query;
+        int word_count = 0;
+        ForEachWordView(query, [&](string_view word) {
+            const auto it = document_freqs.find(word);
+            if (word_count < 1 + static_cast<int>(short_queries.size() % 2) && it != document_freqs.end() && it->second <= 100) {
+                short_query.append(short_query.empty() ? "" : " ").append(word);
+                ++word_count;
+            }
+        });
+        if (!short_query.empty()) {
+            short_queries.push_back(move(short_query));
+        }
+        if (short_queries.size() == 100) {
+            break;
+        }
+    }
+
+    json.BeginObject("baseline");
+    json.Write("postings", postings);
+    json.Write("map_postings", map_server.GetPostingCount());
+    json.Write("map_heap_bytes", static_cast<uint64_t>(map_heap_bytes));
+    json.Write("map_heap_bytes_per_posting", static_cast<double>(map_heap_bytes) / max<size_t>(postings, 1));
+    json.Write("heap_bytes", static_cast<uint64_t>(heap_bytes));
+    json.Write("heap_bytes_per_posting", static_cast<double>(heap_bytes) / max<size_t>(postings, 1));
+
+    // Term frequencies are summed per occurrence in the map index and divided once here,
+    // so relevances may differ in the last bits, and the map index leaves documents with
+    // equal relevance and rating in any order. A rank matches if it holds the same document
+    // or one that ties with it.
+    size_t mismatches = 0;
+    for (const string& query : corpus.queries) {
+        const vector<Document> expected = map_server.FindTopDocuments(query);
+        const vector<Document> actual = search_server.FindTopDocuments(query);
+        mismatches += max(expected.size(), actual.size()) - min(expected.size(), actual.size());
+        for (size_t i = 0; i < min(expected.size(), actual.size()); ++i) {
+            const bool is_tie = abs(expected[i].relevance - actual[i].relevance) < EPS && expected[i].rating == actual[i].rating;
+            mismatches += expected[i].id == actual[i].id || is_tie ? 0 : 1;
+        }
+    }
+    WriteMismatches(json, "mismatched_documents", mismatches);
+
+    WriteLatencies(json, "map_find", MeasureQueries(corpus.queries, options.min_seconds, [&](const string& query, size_t) {
+        map_server.FindTopDocuments(query);
+    }));
+    WriteLatencies(json, "find", MeasureQueries(corpus.queries, options.min_seconds, [&](const string& query, size_t) {
+        search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL);
+    }));
+    if (!short_queries.empty()) {
+        WriteLatencies(json, "map_short_per_query_idf", MeasureQueries(short_queries, options.min_seconds, [&](const string& query, size_t) {
+            map_server.FindTopDocuments(query, IdfMode::PER_QUERY);
+        }));
+        WriteLatencies(json, "map_short_cached_idf", MeasureQueries(short_queries, options.min_seconds, [&](const string& query, size_t) {
+            map_server.FindTopDocuments(query, IdfMode::CACHED);
+        }));
+        WriteLatencies(json, "short", MeasureQueries(short_queries, options.min_seconds, [&](const string& query, size_t) {
+            search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL);
+        }));
+    }
+    json.EndObject();
+}
+
+void RunSnapshot(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus, const SearchServer& search_server) {
+    const string path = "search_server_benchmark.snapshot";
+    json.BeginObject("snapshot");
+    json.Write("save_seconds", MeasureSeconds([&] {
+        search_server.SaveSnapshot(path);
+    }));
+    {
+        ifstream file(path, ios::binary | ios::ate);
+        json.Write("file_bytes", static_cast<uint64_t>(file.tellg()));
+    }
+    json.Write("load_seconds", MeasureSeconds([&] {
+        const SearchServer loaded = SearchServer::LoadSnapshot(path);
+    }));
+    json.Write("rebuild_seconds", MeasureSeconds([&] {
+        const SearchServer rebuilt = BuildServer(corpus);
+    }));
+
+    // The loaded server decodes a term's postings the first time a query reads it, so the
+    // first pass over the queries pays for decoding and the second one does not.
+    const SearchServer loaded = SearchServer::LoadSnapshot(path);
+    remove(path.c_str());
+    json.Write("loaded_memory_bytes", loaded.GetMemoryUsage());
+    json.Write("first_queries_seconds", MeasureSeconds([&] {
+        for (const string& query : corpus.queries) {
+            loaded.FindTopDocuments(query);
+        }
+    }));
+    json.Write("repeated_queries_seconds", MeasureSeconds([&] {
+        for (const string& query : corpus.queries) {
+            loaded.FindTopDocuments(query);
+        }
+    }));
+    json.Write("queried_memory_bytes", loaded.GetMemoryUsage());
+    json.Write("memory_bytes", search_server.GetMemoryUsage());
+    size_t mismatches = 0;
+    for (const string& query : corpus.queries) {
+        mismatches += CountMismatches(search_server.FindTopDocuments(query), loaded.FindTopDocuments(query));
+    }
+    WriteMismatches(json, "mismatched_documents", mismatches);
+    json.EndObject();
+}
+
+void RunPostings(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus, const SearchServer& search_server) {
+    const size_t postings = search_server.GetPostingCount();
+    const size_t bytes = search_server.GetPostingMemoryUsage();
+
+    // The layout before compression: per term, an array of document ids and one of term
+    // frequencies. Terms are inserted first so that only the arrays are measured.
+    struct UncompressedPostings {
+        vector<int> document_ids;
+        vector<double> term_freqs;
+    };
+    map<string_view, UncompressedPostings> uncompressed;
+    for (const int document_id : search_server) {
+        search_server.GetWordFrequencies(document_id).ForEachWord([&uncompressed](string_view word, double) {
+            uncompressed[word];
+        });
+    }
+    const int64_t heap_before = live_heap_bytes.load();
+    for (const int document_id : search_server) {
+        search_server.GetWordFrequencies(document_id).ForEachWord([&uncompressed, document_id](string_view word, double term_freq) {
+            UncompressedPostings& term_postings = uncompressed.at(word);
+            term_postings.document_ids.push_back(document_id);
+            term_postings.term_freqs.push_back(term_freq);
+        });
+    }
+    for (auto& [word, term_postings] : uncompressed) {
+        term_postings.document_ids.shrink_to_fit();
+        term_postings.term_freqs.shrink_to_fit();
+    }
+    const int64_t uncompressed_bytes = live_heap_bytes.load() - heap_before;
+
+    json.BeginObject("postings");
+    json.Write("postings", postings);
+    json.Write("posting_bytes", bytes);
+    json.Write("bytes_per_posting", static_cast<double>(bytes) / max<size_t>(postings, 1));
+    json.Write("uncompressed_posting_bytes", static_cast<uint64_t>(uncompressed_bytes));
+    json.Write("uncompressed_bytes_per_posting", static_cast<double>(uncompressed_bytes) / max<size_t>(postings, 1));
+
+    // A snapshot stores raw counts and the loaded server encodes every list afresh, so tops
+    // of the restored server must be identical.
+    const string path = "search_server_benchmark_postings.snapshot";
+    search_server.SaveSnapshot(path);
+    const SearchServer loaded = SearchServer::LoadSnapshot(path);
+    remove(path.c_str());
+    size_t mismatches = 0;
+    for (const string& query : corpus.queries) {
+        mismatches += CountMismatches(search_server.FindTopDocuments(query), loaded.FindTopDocuments(query));
+    }
+    WriteMismatches(json, "snapshot_mismatched_documents", mismatches);
+    json.EndObject();
+}
+
+void RunChurn(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus) {
+    SearchServer search_server = BuildServer(corpus);
+    const size_t batch_size = max<size_t>(1, corpus.documents.size() / 10);
+    int next_id = corpus.documents.back().id + 1;
+    size_t next_document = 0;
+
+    json.BeginObject("churn");
+    json.Write("initial_memory_bytes", search_server.GetMemoryUsage());
+    json.Write("initial_terms", search_server.GetTermCount());
+    double remove_seq_seconds = 0.0;
+    double remove_par_seconds = 0.0;
+    double add_seconds = 0.0;
+    double compact_seconds = 0.0;
+    size_t memory_before_compact = 0;
+    // The oldest documents are replaced by the same texts under new ids, so every round
+    // holds the whole corpus and memory after compaction must not creep up from round to
+    // round.
+    vector<size_t> compacted_memory;
+    for (size_t round = 0; round < options.churn_rounds; ++round) {
+        vector<int> document_ids(search_server.begin(), search_server.end());
+        document_ids.resize(min(document_ids.size(), batch_size));
+        const size_t half = document_ids.size() / 2;
+        remove_seq_seconds += MeasureSeconds([&] {
+            for (size_t i = 0; i < half; ++i) {
+                search_server.RemoveDocument(execution::seq, document_ids[i]);
+            }
+        });
+        remove_par_seconds += MeasureSeconds([&] {
+            for (size_t i = half; i < document_ids.size(); ++i) {
+                search_server.RemoveDocument(execution::par, document_ids[i]);
+            }
+        });
+
+        vector<NewDocument> documents;
+        for (size_t i = 0; i < document_ids.size(); ++i) {
+            const GeneratedDocument& document = corpus.documents[next_document++ % corpus.documents.size()];
+            documents.push_back({ next_id++, document.text, document.status, document.ratings });
+        }
+        add_seconds += MeasureSeconds([&] {
+            search_server.AddDocuments(execution::par, documents);
+        });
+
+        memory_before_compact = search_server.GetMemoryUsage();
+        compact_seconds += MeasureSeconds([&] {
+            search_server.Compact();
+        });
+        compacted_memory.push_back(search_server.GetMemoryUsage());
+    }
+    const size_t removed = options.churn_rounds * batch_size;
+    json.Write("rounds", options.churn_rounds);
+    json.Write("remove_document_seq_per_second", removed / 2 / remove_seq_seconds);
+    json.Write("remove_document_par_per_second", (removed - removed / 2) / remove_par_seconds);
+    json.Write("add_documents_per_second", removed / add_seconds);
+    json.Write("compact_seconds", compact_seconds / options.churn_rounds);
+    json.Write("memory_before_compact_bytes", memory_before_compact);
+    json.Write("memory_after_compact_bytes", compacted_memory.back());
+    json.Write("terms_after_compact", search_server.GetTermCount());
+    json.BeginArray("memory_after_compact_by_round");
+    for (size_t round = 0; round < compacted_memory.size(); ++round) {
+        json.BeginObject();
+        json.Write("round", round);
+        json.Write("bytes", compacted_memory[round]);
+        json.EndObject();
+    }
+    json.EndArray();
+    // Rounds of the second half whose memory exceeds the largest of the first half by more
+    // than small differences in how the same texts pack under other ids.
+    const size_t half_rounds = max<size_t>(1, compacted_memory.size() / 2);
+    const size_t settled_memory = *max_element(compacted_memory.begin(), compacted_memory.begin() + half_rounds);
+    WriteMismatches(json, "memory_growth_rounds", count_if(compacted_memory.end() - half_rounds, compacted_memory.end(), [settled_memory](size_t bytes) {
+        return bytes > settled_memory + settled_memory / 200;
+    }));
+
+    // Every tenth document is removed one at a time, so removals land inside posting lists
+    // rather than at their front. The index of the whole corpus has posting lists twice as
+    // long as that of its first half; the growth of the time per removal stays near 1 when
+    // a removal rewrites one block of each list and nears 2 when it rewrites whole lists.
+    const auto measure_spread_removal = [&corpus](size_t document_count) {
+        SearchServer search_server(corpus.stop_words);
+        search_server.AddDocuments(execution::par, vector<NewDocument>(corpus.new_documents.begin(), corpus.new_documents.begin() + document_count));
+        vector<int> document_ids;
+        for (size_t i = 5; i < document_count; i += 10) {
+            document_ids.push_back(corpus.new_documents[i].id);
+        }
+        const double seconds = MeasureSeconds([&] {
+            for (const int document_id : document_ids) {
+                search_server.RemoveDocument(document_id);
+            }
+        });
+        return seconds / max<size_t>(1, document_ids.size());
+    };
+    const double spread_removal_seconds = measure_spread_removal(corpus.new_documents.size());
+    json.Write("remove_spread_per_second", 1.0 / spread_removal_seconds);
+    json.Write("remove_spread_time_growth", spread_removal_seconds / measure_spread_removal(corpus.new_documents.size() / 2));
+    json.EndObject();
+}
+
+void RunDuplicates(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus) {
+    // Every tenth document is added once more under a new id.
+    vector<NewDocument> documents = corpus.new_documents;
+    int next_id = corpus.documents.back().id + 1;
+    for (size_t i = 0; i < corpus.new_documents.size(); i += 10) {
+        documents.push_back(corpus.new_documents[i]);
+        documents.back().id = next_id++;
+    }
+    SearchServer search_server(corpus.stop_words);
+    search_server.AddDocuments(execution::par, documents);
+
+    json.BeginObject("duplicates");
+    json.Write("documents", documents.size());
+    vector<int> duplicates;
+    json.Write("find_seq_seconds", MeasureSeconds([&] {
+        duplicates = search_server.FindDuplicates(execution::seq);
+    }));
+    json.Write("find_par_seconds", MeasureSeconds([&] {
+        duplicates = search_server.FindDuplicates(execution::par);
+    }));
+    json.Write("duplicates", duplicates.size());
+    json.Write("remove_seconds", MeasureSeconds([&] {
+        search_server.RemoveDocuments(execution::par, duplicates);
+    }));
+    json.EndObject();
+}
+
+void RunSharded(JsonWriter& json, const BenchmarkOptions& options, const Corpus& corpus, const SearchServer& search_server) {
+    json.BeginArray("sharded");
+    for (size_t shard_count = 1; shard_count <= options.max_threads; shard_count *= 2) {
+        ShardedSearchServer sharded_server(corpus.stop_words, shard_count);
+        json.BeginObject();
+        json.Write("shards", shard_count);
+        json.Write("add_documents_seconds", MeasureSeconds([&] {
+            sharded_server.AddDocuments(corpus.new_documents);
+        }));
+        WriteLatencies(json, "find_top_documents", MeasureQueries(corpus.queries, options.min_seconds, [&](const string& query, size_t) {
+            sharded_server.FindTopDocuments(query);
+        }));
+
+        // Shards share the document frequencies, so tops must equal those of a single server.
+        size_t mismatches = 0;
+        for (const string& query : corpus.queries) {
+            mismatches += CountMismatches(search_server.FindTopDocuments(query), sharded_server.FindTopDocuments(query));
+        }
+        WriteMismatches(json, "mismatched_documents", mismatches);
+        json.EndObject();
+    }
+    json.EndArray();
+}
+
+[[noreturn]] void PrintUsage(const char* program) {
+    cerr << "Usage: "s << program << " [--option=value ...]\n"s
+         << "  --documents --vocabulary --min-length --max-length --zipf --stop-words --stop-word-ratio\n"s
+         << "  --queries --min-query-length --max-query-length --minus-ratio --distinct-queries --seed\n"s
+         << "  --threads --cache-capacity --min-seconds --batch-sizes=1000,10000,100000 --churn-rounds --output=FILE\n"s
+         << "  --sections=corpus,tokenizer,ingest,find,match,process,scaling,concurrent,cache,request_queue,baseline,snapshot,postings,churn,duplicates,sharded,thread_pool,deadlines\n"s;
+    exit(2);
+}
+
+BenchmarkOptions ParseOptions(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    CorpusOptions& corpus = options.corpus;
+    const map<string_view, function<void(const string&)>> setters = {
+        { "documents"sv, [&](const string& value) { corpus.document_count = stoull(value); } },
+        { "vocabulary"sv, [&](const string& value) { corpus.vocabulary_size = stoull(value); } },
+        { "min-length"sv, [&](const string& value) { corpus.min_document_length = stoull(value); } },
+        { "max-length"sv, [&](const string& value) { corpus.max_document_length = stoull(value); } },
+        { "zipf"sv, [&](const string& value) { corpus.zipf_exponent = stod(value); } },
+        { "stop-words"sv, [&](const string& value) { corpus.stop_word_count = stoull(value); } },
+        { "stop-word-ratio"sv, [&](const string& value) { corpus.stop_word_ratio = stod(value); } },
+        { "queries"sv, [&](const string& value) { corpus.query_count = stoull(value); } },
+        { "min-query-length"sv, [&](const string& value) { corpus.min_query_length = stoull(value); } },
+        { "max-query-length"sv, [&](const string& value) { corpus.max_query_length = stoull(value); } },
+        { "minus-ratio"sv, [&](const string& value) { corpus.minus_word_ratio = stod(value); } },
+        { "distinct-queries"sv, [&](const string& value) { corpus.distinct_query_count = stoull(value); } },
+        { "seed"sv, [&](const string& value) { corpus.seed = stoull(value); } },
+        { "threads"sv, [&](const string& value) { options.max_threads = max<size_t>(1, stoull(value)); } },
+        { "cache-capacity"sv, [&](const string& value) { options.cache_capacity = stoull(value); } },
+        { "min-seconds"sv, [&](const string& value) { options.min_seconds = stod(value); } },
+        { "churn-rounds"sv, [&](const string& value) { options.churn_rounds = max<size_t>(1, stoull(value)); } },
+        { "output"sv, [&](const string& value) { options.output = value; } },
+        { "batch-sizes"sv, [&](const string& value) {
+            istringstream batch_sizes(value);
+            options.batch_sizes.clear();
+            for (string batch_size; getline(batch_sizes, batch_size, ',');) {
+                options.batch_sizes.push_back(stoull(batch_size));
+            }
+        } },
+        { "sections"sv, [&](const string& value) {
+            istringstream sections(value);
+            for (string section; getline(sections, section, ',');) {
+                options.sections.insert(section);
+            }
+        } },
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        const string_view argument = argv[i];
+        const size_t equal_pos = argument.find('=');
+        if (argument.substr(0, 2) != "--"sv || equal_pos == argument.npos) {
+            PrintUsage(argv[0]);
+        }
+        const auto setter = setters.find(argument.substr(2, equal_pos - 2));
+        if (setter == setters.end()) {
+            PrintUsage(argv[0]);
+        }
+        try {
+            setter->second(string(argument.substr(equal_pos + 1)));
+        }
+        catch (const logic_error&) {
+            PrintUsage(argv[0]);
+        }
+    }
+    if (corpus.document_count == 0 || corpus.query_count == 0 || corpus.vocabulary_size == 0 || corpus.min_document_length > corpus.max_document_length || corpus.min_query_length > corpus.max_query_length) {
+        PrintUsage(argv[0]);
+    }
+    return options;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const BenchmarkOptions options = ParseOptions(argc, argv);
+    const auto is_enabled = [&options](const string& section) {
+        return options.sections.empty() || options.sections.count(section) > 0;
+    };
+
+    Corpus corpus;
+    CorpusGenerator generator(options.corpus);
+    corpus.stop_words = generator.GetStopWords();
+    corpus.documents = generator.GenerateDocuments();
+    corpus.queries = generator.GenerateQueries();
+    for (const GeneratedDocument& document : corpus.documents) {
+        corpus.new_documents.push_back({ document.id, document.text, document.status, document.ratings });
+        corpus.text_bytes += document.text.size();
+    }
+
+    ofstream output_file;
+    if (!options.output.empty()) {
+        output_file.open(options.output);
+    }
+    ostream& output = options.output.empty() ? cout : output_file;
+    JsonWriter json(output);
+    json.BeginObject();
+
+    const auto run = [&](const string& section, auto function) {
+        if (is_enabled(section)) {
+            cerr << "running "s << section << endl;
+            function();
+        }
+    };
+    run("corpus"s, [&] { RunCorpus(json, options, corpus); });
+    run("tokenizer"s, [&] { RunTokenizer(json, options, corpus); });
+    run("ingest"s, [&] { RunIngest(json, options, corpus); });
+
+    const SearchServer search_server = BuildServer(corpus);
+    run("find"s, [&] { RunFindTopDocuments(json, options, corpus, search_server); });
+    run("match"s, [&] { RunMatchDocument(json, options, corpus, search_server); });
+    run("process"s, [&] { RunProcessQueries(json, options, corpus, search_server); });
+    run("scaling"s, [&] { RunParallelScaling(json, options, corpus, search_server); });
+    run("concurrent"s, [&] { RunConcurrent(json, options, corpus); });
+    run("cache"s, [&] { RunQueryCache(json, options, corpus, search_server); });
+    run("request_queue"s, [&] { RunRequestQueue(json, options, corpus, search_server); });
+    run("baseline"s, [&] { RunBaseline(json, options, corpus); });
+    run("snapshot"s, [&] { RunSnapshot(json, options, corpus, search_server); });
+    run("postings"s, [&] { RunPostings(json, options, corpus, search_server); });
+    run("churn"s, [&] { RunChurn(json, options, corpus); });
+    run("duplicates"s, [&] { RunDuplicates(json, options, corpus); });
+    run("sharded"s, [&] { RunSharded(json, options, corpus, search_server); });
+    run("thread_pool"s, [&] { RunThreadPool(json, options, corpus, search_server); });
+    run("deadlines"s, [&] { RunDeadlines(json, options, corpus, search_server); });
+
+    json.EndObject();
+    return failed_check_count == 0 ? 0 : 1;
+}
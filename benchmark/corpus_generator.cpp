@@ -0,0 +1,112 @@
+#include "corpus_generator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std::string_literals;
+
+CorpusGenerator::CorpusGenerator(const CorpusOptions& options)
+    : options_(options)
+    , generator_(options.seed)
+    , word_distribution_(MakeZipfDistribution(options.vocabulary_size, options.zipf_exponent))
+    , query_distribution_(MakeZipfDistribution(options.distinct_query_count, options.zipf_exponent)) {
+}
+
+std::string CorpusGenerator::GetStopWords() const {
+    std::string stop_words;
+    for (size_t i = 0; i < options_.stop_word_count; ++i) {
+        if (i > 0) {
+            stop_words.push_back(' ');
+        }
+        stop_words += "stop"s + MakeWord(i);
+    }
+    return stop_words;
+}
+
+std::vector<GeneratedDocument> CorpusGenerator::GenerateDocuments() {
+    std::vector<GeneratedDocument> documents;
+    documents.reserve(options_.document_count);
+    for (size_t i = 0; i < options_.document_count; ++i) {
+        const double status_draw = NextUniform();
+        const DocumentStatus status = status_draw < 0.85 ? DocumentStatus::ACTUAL
+            : status_draw < 0.9 ? DocumentStatus::IRRELEVANT
+            : status_draw < 0.95 ? DocumentStatus::BANNED
+            : DocumentStatus::REMOVED;
+
+        std::vector<int> ratings(NextInRange(0, 4));
+        for (int& rating : ratings) {
+            rating = static_cast<int>(NextInRange(0, 20)) - 5;
+        }
+
+        documents.push_back({ static_cast<int>(i), NextText(options_.min_document_length, options_.max_document_length, 0.0), status, std::move(ratings) });
+    }
+    return documents;
+}
+
+std::vector<std::string> CorpusGenerator::GenerateQueries() {
+    std::vector<std::string> pool;
+    if (options_.distinct_query_count > 0) {
+        pool.reserve(options_.distinct_query_count);
+        for (size_t i = 0; i < options_.distinct_query_count; ++i) {
+            pool.push_back(NextText(options_.min_query_length, options_.max_query_length, options_.minus_word_ratio));
+        }
+    }
+
+    std::vector<std::string> queries;
+    queries.reserve(options_.query_count);
+    for (size_t i = 0; i < options_.query_count; ++i) {
+        queries.push_back(pool.empty() ? NextText(options_.min_query_length, options_.max_query_length, options_.minus_word_ratio) : pool[NextZipf(query_distribution_)]);
+    }
+    return queries;
+}
+
+std::string CorpusGenerator::MakeWord(size_t rank) {
+    std::string word;
+    do {
+        word.push_back(static_cast<char>('a' + rank % 26));
+        rank /= 26;
+    } while (rank > 0);
+    return word;
+}
+
+double CorpusGenerator::NextUniform() {
+    return static_cast<double>(generator_() >> 11) * 0x1.0p-53;
+}
+
+size_t CorpusGenerator::NextZipf(const std::vector<double>& cumulative) {
+    const auto it = std::upper_bound(cumulative.begin(), cumulative.end(), NextUniform() * cumulative.back());
+    return std::min<size_t>(it - cumulative.begin(), cumulative.size() - 1);
+}
+
+size_t CorpusGenerator::NextInRange(size_t min, size_t max) {
+    return min + static_cast<size_t>(NextUniform() * (max - min + 1));
+}
+
+std::string CorpusGenerator::NextText(size_t min_length, size_t max_length, double minus_word_ratio) {
+    std::string text;
+    const size_t length = std::max<size_t>(1, NextInRange(min_length, max_length));
+    for (size_t i = 0; i < length; ++i) {
+        if (i > 0) {
+            text.push_back(' ');
+        }
+        if (options_.stop_word_count > 0 && NextUniform() < options_.stop_word_ratio) {
+            text += "stop"s + MakeWord(NextInRange(0, options_.stop_word_count - 1));
+            continue;
+        }
+        if (NextUniform() < minus_word_ratio) {
+            text.push_back('-');
+        }
+        text += MakeWord(NextZipf(word_distribution_));
+    }
+    return text;
+}
+
+std::vector<double> CorpusGenerator::MakeZipfDistribution(size_t size, double exponent) {
+    std::vector<double> cumulative(size);
+    double sum = 0.0;
+    for (size_t rank = 0; rank < size; ++rank) {
+        sum += 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+        cumulative[rank] = sum;
+    }
+    return cumulative;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "document.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+struct CorpusOptions {
+    size_t document_count = 100000;
+    size_t vocabulary_size = 50000;
+    size_t min_document_length = 10;
+    size_t max_document_length = 100;
+    double zipf_exponent = 1.0;
+    size_t stop_word_count = 20;
+    double stop_word_ratio = 0.1;
+    size_t query_count = 10000;
+    size_t min_query_length = 1;
+    size_t max_query_length = 5;
+    double minus_word_ratio = 0.1;
+    // Queries are drawn from a pool of this many distinct queries with a Zipf
+    // distribution, so the log repeats like real traffic does; 0 makes every query unique.
+    size_t distinct_query_count = 0;
+    uint64_t seed = 42;
+};
+
+struct GeneratedDocument {
+    int id;
+    std::string text;
+    DocumentStatus status;
+    std::vector<int> ratings;
+};
+
+// Deterministic synthetic corpus: word frequencies follow a Zipf law over the vocabulary,
+// stop words are mixed in at stop_word_ratio, and the same options and seed always give
+// the same corpus and query log.
+class CorpusGenerator {
+public:
+    explicit CorpusGenerator(const CorpusOptions& options);
+
+    std::string GetStopWords() const;
+    std::vector<GeneratedDocument> GenerateDocuments();
+    std::vector<std::string> GenerateQueries();
+
+    static std::string MakeWord(size_t rank);
+
+private:
+    double NextUniform();
+    size_t NextZipf(const std::vector<double>& cumulative);
+    size_t NextInRange(size_t min, size_t max);
+    std::string NextText(size_t min_length, size_t max_length, double minus_word_ratio);
+
+    static std::vector<double> MakeZipfDistribution(size_t size, double exponent);
+
+    CorpusOptions options_;
+    std::mt19937_64 generator_;
+    std::vector<double> word_distribution_;
+    std::vector<double> query_distribution_;
+};
@@ -0,0 +1,87 @@
+#include "json_writer.h"
+
+#include <cmath>
+#include <iomanip>
+
+JsonWriter::JsonWriter(std::ostream& output) : output_(output) {}
+
+void JsonWriter::BeginObject(std::string_view key) {
+    WriteKey(key);
+    output_ << '{';
+    ++depth_;
+    is_first_ = true;
+}
+
+void JsonWriter::EndObject() {
+    --depth_;
+    output_ << '\n' << std::string(2 * depth_, ' ') << '}';
+    is_first_ = false;
+    if (depth_ == 0) {
+        output_ << '\n';
+    }
+}
+
+void JsonWriter::BeginArray(std::string_view key) {
+    WriteKey(key);
+    output_ << '[';
+    ++depth_;
+    is_first_ = true;
+}
+
+void JsonWriter::EndArray() {
+    --depth_;
+    output_ << '\n' << std::string(2 * depth_, ' ') << ']';
+    is_first_ = false;
+}
+
+void JsonWriter::Write(std::string_view key, double value) {
+    WriteKey(key);
+    if (std::isfinite(value)) {
+        output_ << std::setprecision(6) << value;
+    }
+    else {
+        output_ << "null";
+    }
+}
+
+void JsonWriter::Write(std::string_view key, uint64_t value) {
+    WriteKey(key);
+    output_ << value;
+}
+
+void JsonWriter::Write(std::string_view key, int value) {
+    WriteKey(key);
+    output_ << value;
+}
+
+void JsonWriter::Write(std::string_view key, std::string_view value) {
+    WriteKey(key);
+    WriteString(value);
+}
+
+void JsonWriter::WriteKey(std::string_view key) {
+    if (depth_ > 0) {
+        output_ << (is_first_ ? "\n" : ",\n") << std::string(2 * depth_, ' ');
+    }
+    is_first_ = false;
+    if (!key.empty()) {
+        WriteString(key);
+        output_ << ": ";
+    }
+}
+
+void JsonWriter::WriteString(std::string_view text) {
+    output_ << '"';
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            output_ << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            output_ << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+        }
+        else {
+            output_ << c;
+        }
+    }
+    output_ << '"';
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Streams a JSON document; keys are written in call order.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::ostream& output);
+
+    void BeginObject(std::string_view key = {});
+    void EndObject();
+    void BeginArray(std::string_view key);
+    void EndArray();
+
+    void Write(std::string_view key, double value);
+    void Write(std::string_view key, uint64_t value);
+    void Write(std::string_view key, int value);
+    void Write(std::string_view key, std::string_view value);
+
+private:
+    void WriteKey(std::string_view key);
+    void WriteString(std::string_view text);
+
+    std::ostream& output_;
+    int depth_ = 0;
+    bool is_first_ = true;
+};
@@ -0,0 +1,111 @@
+#include "map_search_server.h"
+
+#include "config.h"
+#include "string_processing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+MapSearchServer::MapSearchServer(std::string_view stop_words_text)
+    : stop_words_(MakeUniqueNonEmptyStrings(SplitIntoWordsView(stop_words_text))) {
+}
+
+void MapSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    const int rating = ratings.empty() ? 0 : std::accumulate(ratings.begin(), ratings.end(), 0) / static_cast<int>(ratings.size());
+    const std::string& text = documents_.emplace(document_id, DocumentData{ rating, status, std::string(document) }).first->second.text;
+
+    std::vector<std::string_view> words;
+    ForEachWordView(text, [this, &words](std::string_view word) {
+        if (stop_words_.count(word) == 0) {
+            words.push_back(word);
+        }
+    });
+    const double inverse_word_count = 1.0 / words.size();
+    auto& word_freqs = document_to_word_freqs_[document_id];
+    for (const std::string_view word : words) {
+        auto it = word_to_document_freqs_.find(word);
+        if (it == word_to_document_freqs_.end()) {
+            it = word_to_document_freqs_.emplace(std::string(word), TermPostings()).first;
+        }
+        double& term_freq = it->second.document_freqs[document_id];
+        if (term_freq == 0.0) {
+            ++posting_count_;
+        }
+        term_freq += inverse_word_count;
+        word_freqs[it->first] += inverse_word_count;
+    }
+    for (const auto& [word, term_freq] : word_freqs) {
+        TermPostings& postings = word_to_document_freqs_.find(word)->second;
+        postings.log_document_freq = std::log(postings.document_freqs.size());
+    }
+}
+
+std::vector<Document> MapSearchServer::FindTopDocuments(std::string_view raw_query, IdfMode idf_mode) const {
+    const Query query = ParseQuery(raw_query);
+    const double log_document_count = std::log(documents_.size());
+
+    std::map<int, double> document_to_relevance;
+    for (const std::string_view word : query.plus_words) {
+        const auto it = word_to_document_freqs_.find(word);
+        if (it == word_to_document_freqs_.end()) {
+            continue;
+        }
+        const double inverse_document_freq = idf_mode == IdfMode::CACHED ? log_document_count - it->second.log_document_freq : ComputeWordInverseDocumentFreq(word);
+        for (const auto [document_id, term_freq] : it->second.document_freqs) {
+            if (documents_.at(document_id).status == DocumentStatus::ACTUAL) {
+                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+            }
+        }
+    }
+    for (const std::string_view word : query.minus_words) {
+        const auto it = word_to_document_freqs_.find(word);
+        if (it == word_to_document_freqs_.end()) {
+            continue;
+        }
+        for (const auto [document_id, term_freq] : it->second.document_freqs) {
+            document_to_relevance.erase(document_id);
+        }
+    }
+
+    std::vector<Document> matched_documents;
+    for (const auto [document_id, relevance] : document_to_relevance) {
+        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+    }
+    std::sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
+        if (std::abs(lhs.relevance - rhs.relevance) < EPS) {
+            return lhs.rating > rhs.rating;
+        }
+        return lhs.relevance > rhs.relevance;
+    });
+    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    }
+    return matched_documents;
+}
+
+size_t MapSearchServer::GetPostingCount() const noexcept {
+    return posting_count_;
+}
+
+MapSearchServer::Query MapSearchServer::ParseQuery(std::string_view text) const {
+    Query query;
+    ForEachWordView(text, [this, &query](std::string_view word) {
+        const bool is_minus = !word.empty() && word[0] == '-';
+        if (is_minus) {
+            word.remove_prefix(1);
+        }
+        if (!word.empty() && stop_words_.count(word) == 0) {
+            (is_minus ? query.minus_words : query.plus_words).push_back(word);
+        }
+    });
+    for (auto* words : { &query.plus_words, &query.minus_words }) {
+        std::sort(words->begin(), words->end());
+        words->erase(std::unique(words->begin(), words->end()), words->end());
+    }
+    return query;
+}
+
+double MapSearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const {
+    return std::log(documents_.size() * 1.0 / word_to_document_freqs_.find(word)->second.document_freqs.size());
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "document.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class IdfMode {
+    // std::log and a second dictionary lookup for every query term, as the server did
+    // before it cached IDF inputs.
+    PER_QUERY,
+    // log(document frequency) kept with the term and updated by AddDocument.
+    CACHED,
+};
+
+// The std::map based index SearchServer used before its posting arrays: word -> document
+// -> term frequency, a mirrored forward index and full copies of the texts. It is kept
+// only as a baseline for memory and query latency, so it reproduces AddDocument and the
+// sequential FindTopDocuments for ACTUAL documents and nothing else.
+class MapSearchServer {
+public:
+    explicit MapSearchServer(std::string_view stop_words_text);
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, IdfMode idf_mode = IdfMode::PER_QUERY) const;
+
+    size_t GetPostingCount() const noexcept;
+
+private:
+    struct DocumentData {
+        int rating;
+        DocumentStatus status;
+        std::string text;
+    };
+
+    struct TermPostings {
+        std::map<int, double> document_freqs;
+        // Only read with IdfMode::CACHED; one double per term, not per posting.
+        double log_document_freq = 0.0;
+    };
+
+    struct Query {
+        std::vector<std::string_view> plus_words;
+        std::vector<std::string_view> minus_words;
+    };
+
+    Query ParseQuery(std::string_view text) const;
+    double ComputeWordInverseDocumentFreq(std::string_view word) const;
+
+    std::set<std::string, std::less<>> stop_words_;
+    std::map<std::string, TermPostings, std::less<>> word_to_document_freqs_;
+    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
+    std::map<int, DocumentData> documents_;
+    size_t posting_count_ = 0;
+};
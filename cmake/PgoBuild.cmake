@@ -0,0 +1,33 @@
+# Builds the "pgo" preset: an instrumented benchmark is trained on the benchmark query
+# mix, then everything is rebuilt with the collected profiles and LTO.
+#
+#   cmake -P cmake/PgoBuild.cmake
+#
+# TRAINING_ARGS overrides the benchmark options used for training.
+
+cmake_minimum_required(VERSION 3.21)
+
+get_filename_component(source_dir "${CMAKE_CURRENT_LIST_DIR}/.." ABSOLUTE)
+set(profile_dir "${source_dir}/build/pgo-profiles")
+if(NOT DEFINED TRAINING_ARGS)
+    set(TRAINING_ARGS --documents=50000 --queries=5000 --min-seconds=0.2 --sections=ingest,find,match,process,cache,request_queue,snapshot,churn)
+endif()
+
+function(run)
+    execute_process(COMMAND ${ARGV} WORKING_DIRECTORY "${source_dir}" COMMAND_ERROR_IS_FATAL ANY)
+endfunction()
+
+file(REMOVE_RECURSE "${profile_dir}")
+run(${CMAKE_COMMAND} --preset pgo-generate)
+run(${CMAKE_COMMAND} --build --preset pgo-generate --target search_server_benchmark)
+run("${source_dir}/build/pgo-generate/benchmark/search_server_benchmark" ${TRAINING_ARGS}
+    --output=${source_dir}/build/pgo-generate/training.json)
+
+file(GLOB clang_profiles "${profile_dir}/*.profraw")
+if(clang_profiles)
+    find_program(llvm_profdata NAMES llvm-profdata REQUIRED)
+    run(${llvm_profdata} merge -output=${profile_dir}/default.profdata ${clang_profiles})
+endif()
+
+run(${CMAKE_COMMAND} --preset pgo)
+run(${CMAKE_COMMAND} --build --preset pgo)
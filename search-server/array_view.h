@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Read-only run of contiguous values stored elsewhere: the elements of a vector or an
+// array inside a mapped file. The view does not own them.
+template <typename Value>
+class ArrayView {
+public:
+    ArrayView() = default;
+    ArrayView(const Value* data, size_t size) noexcept;
+    ArrayView(const std::vector<Value>& values) noexcept;
+
+    const Value* begin() const noexcept;
+    const Value* end() const noexcept;
+    const Value* data() const noexcept;
+    size_t size() const noexcept;
+    bool empty() const noexcept;
+    const Value& operator[](size_t index) const noexcept;
+
+private:
+    const Value* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+template <typename Value>
+ArrayView<Value>::ArrayView(const Value* data, size_t size) noexcept
+    : data_(data)
+    , size_(size) {
+}
+
+template <typename Value>
+ArrayView<Value>::ArrayView(const std::vector<Value>& values) noexcept
+    : data_(values.data())
+    , size_(values.size()) {
+}
+
+template <typename Value>
+const Value* ArrayView<Value>::begin() const noexcept {
+    return data_;
+}
+
+template <typename Value>
+const Value* ArrayView<Value>::end() const noexcept {
+    return data_ + size_;
+}
+
+template <typename Value>
+const Value* ArrayView<Value>::data() const noexcept {
+    return data_;
+}
+
+template <typename Value>
+size_t ArrayView<Value>::size() const noexcept {
+    return size_;
+}
+
+template <typename Value>
+bool ArrayView<Value>::empty() const noexcept {
+    return size_ == 0;
+}
+
+template <typename Value>
+const Value& ArrayView<Value>::operator[](size_t index) const noexcept {
+    return data_[index];
+}
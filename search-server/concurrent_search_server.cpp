@@ -0,0 +1,54 @@
+#include "concurrent_search_server.h"
+
+ConcurrentSearchServer::ConcurrentSearchServer(const std::string& stop_words_text)
+    : ConcurrentSearchServer(SplitIntoWords(stop_words_text)) {
+}
+
+ConcurrentSearchServer::ConcurrentSearchServer(std::string_view stop_words_text)
+    : ConcurrentSearchServer(SplitIntoWordsView(stop_words_text)) {
+}
+
+void ConcurrentSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    Write([&](SearchServer& search_server) {
+        search_server.AddDocument(document_id, document, status, ratings);
+        return true;
+    });
+}
+
+std::vector<std::exception_ptr> ConcurrentSearchServer::AddDocuments(const std::vector<NewDocument>& documents) {
+    return Write([&documents](SearchServer& search_server) {
+        return search_server.AddDocuments(std::execution::par, documents);
+    });
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id) {
+    Write([document_id](SearchServer& search_server) {
+        search_server.RemoveDocument(document_id);
+        return true;
+    });
+}
+
+int ConcurrentSearchServer::GetDocumentCount() const {
+    return Read([](const SearchServer& search_server) {
+        return search_server.GetDocumentCount();
+    });
+}
+
+ConcurrentSearchServer::ReadGuard::ReadGuard(const ConcurrentSearchServer& server) : server_(server) {
+    while (true) {
+        index_ = server_.active_.load();
+        server_.readers_[index_].value.fetch_add(1);
+        if (server_.active_.load() == index_) {
+            return;
+        }
+        server_.readers_[index_].value.fetch_sub(1);
+    }
+}
+
+ConcurrentSearchServer::ReadGuard::~ReadGuard() {
+    server_.readers_[index_].value.fetch_sub(1);
+}
+
+size_t ConcurrentSearchServer::ReadGuard::GetIndex() const noexcept {
+    return index_;
+}
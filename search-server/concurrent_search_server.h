@@ -0,0 +1,122 @@
+#pragma once
+
+#include "search_server.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Keeps two copies of the index. Readers always work on the published copy and never
+// wait for writers; a writer updates the standby copy, publishes it atomically, waits
+// until readers of the previous copy have left and then replays the same change there.
+class ConcurrentSearchServer {
+public:
+    template <typename StringContainer>
+    explicit ConcurrentSearchServer(const StringContainer& stop_words);
+
+    explicit ConcurrentSearchServer(const std::string& stop_words_text);
+
+    explicit ConcurrentSearchServer(std::string_view stop_words_text);
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    std::vector<std::exception_ptr> AddDocuments(const std::vector<NewDocument>& documents);
+    void RemoveDocument(int document_id);
+
+    template <typename... Args>
+    std::vector<Document> FindTopDocuments(Args&&... args) const;
+
+    template <typename... Args>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(Args&&... args) const;
+
+    template <typename... Args>
+    DocumentMatches MatchDocuments(Args&&... args) const;
+
+    int GetDocumentCount() const;
+
+    template <typename Function>
+    auto Read(Function function) const;
+
+private:
+    struct alignas(64) ReaderCounter {
+        std::atomic<int64_t> value = 0;
+    };
+
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const ConcurrentSearchServer& server);
+        ~ReadGuard();
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        size_t GetIndex() const noexcept;
+
+    private:
+        const ConcurrentSearchServer& server_;
+        size_t index_;
+    };
+
+    template <typename Function>
+    auto Write(Function function);
+
+    std::array<SearchServer, 2> instances_;
+    std::atomic<size_t> active_ = 0;
+    mutable std::array<ReaderCounter, 2> readers_;
+    std::mutex write_mutex_;
+};
+
+template <typename StringContainer>
+ConcurrentSearchServer::ConcurrentSearchServer(const StringContainer& stop_words)
+    : instances_{ SearchServer(stop_words), SearchServer(stop_words) } {
+}
+
+template <typename... Args>
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(Args&&... args) const {
+    return Read([&args...](const SearchServer& search_server) {
+        return search_server.FindTopDocuments(std::forward<Args>(args)...);
+    });
+}
+
+template <typename... Args>
+std::tuple<std::vector<std::string_view>, DocumentStatus> ConcurrentSearchServer::MatchDocument(Args&&... args) const {
+    return Read([&args...](const SearchServer& search_server) {
+        return search_server.MatchDocument(std::forward<Args>(args)...);
+    });
+}
+
+template <typename... Args>
+DocumentMatches ConcurrentSearchServer::MatchDocuments(Args&&... args) const {
+    return Read([&args...](const SearchServer& search_server) {
+        return search_server.MatchDocuments(std::forward<Args>(args)...);
+    });
+}
+
+template <typename Function>
+auto ConcurrentSearchServer::Read(Function function) const {
+    const ReadGuard guard(*this);
+    return function(instances_[guard.GetIndex()]);
+}
+
+template <typename Function>
+auto ConcurrentSearchServer::Write(Function function) {
+    std::lock_guard guard(write_mutex_);
+    const size_t standby = 1 - active_.load();
+
+    // A rejected change throws here, before anything is published.
+    auto result = function(instances_[standby]);
+    active_.store(standby);
+
+    const size_t retired = 1 - standby;
+    while (readers_[retired].value.load() != 0) {
+        std::this_thread::yield();
+    }
+    function(instances_[retired]);
+    return result;
+}
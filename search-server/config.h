@@ -3,4 +3,9 @@
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 const double EPS = 1e-6;
 const int MIN_IN_DAY = 1440;
-const int BUCKET_COUNT = 16;
+const int RANGES_PER_THREAD = 4;
+const int QUERY_GROUP_SIZE = 256;
+const int TASKS_PER_WORKER = 4;
+const int MIN_PARALLEL_SORT_CHUNK = 4096;
+const int MIN_PARALLEL_MATCH_CHUNK = 4096;
+const int DEADLINE_CHECK_INTERVAL = 256;
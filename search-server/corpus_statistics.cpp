@@ -0,0 +1,52 @@
+#include "corpus_statistics.h"
+
+#include <cmath>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+void CorpusStatistics::AddDocument(const WordFrequencies& word_freqs) {
+    word_freqs.ForEachWord([this](std::string_view word, double) {
+        auto it = terms_.find(word);
+        if (it == terms_.end()) {
+            auto term = std::make_unique<std::string>(word);
+            const std::string_view key = *term;
+            it = terms_.emplace(key, TermStatistics{ std::move(term), 0, 0.0 }).first;
+        }
+        TermStatistics& statistics = it->second;
+        ++statistics.document_freq;
+        statistics.log_document_freq = std::log(statistics.document_freq);
+    });
+    ++document_count_;
+    log_document_count_ = std::log(document_count_);
+}
+
+void CorpusStatistics::RemoveDocument(const WordFrequencies& word_freqs) {
+    word_freqs.ForEachWord([this](std::string_view word, double) {
+        const auto it = terms_.find(word);
+        if (it == terms_.end()) {
+            return;
+        }
+        TermStatistics& statistics = it->second;
+        if (--statistics.document_freq == 0) {
+            terms_.erase(it);
+        }
+        else {
+            statistics.log_document_freq = std::log(statistics.document_freq);
+        }
+    });
+    --document_count_;
+    log_document_count_ = std::log(document_count_);
+}
+
+int CorpusStatistics::GetDocumentCount() const noexcept {
+    return document_count_;
+}
+
+double CorpusStatistics::ComputeInverseDocumentFreq(std::string_view word) const {
+    const auto it = terms_.find(word);
+    if (it == terms_.end()) {
+        throw std::out_of_range("word is not in the corpus"s);
+    }
+    return log_document_count_ - it->second.log_document_freq;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "word_frequencies.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Document frequencies of a corpus split across several servers. Servers scoring with it
+// compute the IDF of the whole corpus, bit for bit as a single server holding it would.
+class CorpusStatistics {
+public:
+    void AddDocument(const WordFrequencies& word_freqs);
+    void RemoveDocument(const WordFrequencies& word_freqs);
+
+    int GetDocumentCount() const noexcept;
+    // The word must occur in at least one document.
+    double ComputeInverseDocumentFreq(std::string_view word) const;
+
+private:
+    struct TermStatistics {
+        std::unique_ptr<std::string> term;
+        size_t document_freq;
+        double log_document_freq;
+    };
+
+    // Keys view the term owned by their value, which does not move on rehashing.
+    std::unordered_map<std::string_view, TermStatistics> terms_;
+    int document_count_ = 0;
+    double log_document_count_ = 0.0;
+};
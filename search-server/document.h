@@ -2,6 +2,8 @@
 
 #include <fstream>
 #include <iostream>
+#include <string_view>
+#include <vector>
 
 #include "config.h"
 
@@ -24,4 +26,11 @@ enum class DocumentStatus {
     REMOVED,
 };
 
+struct NewDocument {
+    int id = 0;
+    std::string_view text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
+
 std::ostream& operator<<(std::ostream& out, const Document& document);
@@ -0,0 +1,59 @@
+#include "document_attributes.h"
+
+#include <algorithm>
+
+void DocumentAttributeTable::Set(int document_id, const DocumentAttributes& attributes) {
+    const size_t index = static_cast<size_t>(document_id);
+    const size_t page_index = index / PAGE_SIZE;
+    if (pages_.empty()) {
+        first_page_ = page_index;
+    }
+    else if (page_index < first_page_) {
+        const size_t added = first_page_ - page_index;
+        pages_.resize(pages_.size() + added);
+        std::move_backward(pages_.begin(), pages_.end() - added, pages_.end());
+        live_counts_.insert(live_counts_.begin(), added, 0);
+        first_page_ = page_index;
+    }
+    if (page_index - first_page_ >= pages_.size()) {
+        pages_.resize(page_index - first_page_ + 1);
+        live_counts_.resize(pages_.size());
+    }
+
+    auto& page = pages_[page_index - first_page_];
+    if (!page) {
+        page = std::make_unique<DocumentAttributes[]>(PAGE_SIZE);
+        ++page_count_;
+    }
+    page[index % PAGE_SIZE] = attributes;
+    ++live_counts_[page_index - first_page_];
+}
+
+void DocumentAttributeTable::Erase(int document_id) {
+    const size_t page = static_cast<size_t>(document_id) / PAGE_SIZE - first_page_;
+    if (--live_counts_[page] == 0) {
+        pages_[page].reset();
+        --page_count_;
+    }
+}
+
+void DocumentAttributeTable::Shrink() {
+    const auto is_live = [](uint32_t live_count) {
+        return live_count > 0;
+    };
+    const size_t last = live_counts_.rend() - std::find_if(live_counts_.rbegin(), live_counts_.rend(), is_live);
+    const size_t first = std::find_if(live_counts_.begin(), live_counts_.begin() + last, is_live) - live_counts_.begin();
+
+    pages_.erase(pages_.begin() + last, pages_.end());
+    pages_.erase(pages_.begin(), pages_.begin() + first);
+    pages_.shrink_to_fit();
+    live_counts_.erase(live_counts_.begin() + last, live_counts_.end());
+    live_counts_.erase(live_counts_.begin(), live_counts_.begin() + first);
+    live_counts_.shrink_to_fit();
+    first_page_ += first;
+}
+
+size_t DocumentAttributeTable::GetMemoryUsage() const noexcept {
+    return pages_.capacity() * sizeof(std::unique_ptr<DocumentAttributes[]>) + live_counts_.capacity() * sizeof(uint32_t)
+        + page_count_ * PAGE_SIZE * sizeof(DocumentAttributes);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "document.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// What scoring reads for every candidate document. The length counts the document's
+// words without stop words.
+struct DocumentAttributes {
+    uint32_t length;
+    int rating;
+    DocumentStatus status;
+};
+
+// Attributes of every document, addressed directly by id, so scoring reads them with two
+// loads instead of a tree lookup. Ids are split into pages that are allocated when the
+// first document lands in them and freed when the last one is erased; Shrink drops the
+// empty slots at both ends of the page table, so ids that keep growing under churn do
+// not leave a trail behind them.
+class DocumentAttributeTable {
+public:
+    // document_id must not be set already.
+    void Set(int document_id, const DocumentAttributes& attributes);
+    // document_id must be set.
+    void Erase(int document_id);
+    // document_id must be set.
+    const DocumentAttributes& Get(int document_id) const noexcept;
+
+    void Shrink();
+    size_t GetMemoryUsage() const noexcept;
+
+private:
+    static constexpr size_t PAGE_SIZE = 1024;
+
+    // pages_[i] holds ids starting at (first_page_ + i) * PAGE_SIZE; live_counts_[i] is the
+    // number of ids set in it.
+    std::vector<std::unique_ptr<DocumentAttributes[]>> pages_;
+    std::vector<uint32_t> live_counts_;
+    size_t first_page_ = 0;
+    size_t page_count_ = 0;
+};
+
+inline const DocumentAttributes& DocumentAttributeTable::Get(int document_id) const noexcept {
+    const size_t index = static_cast<size_t>(document_id);
+    return pages_[index / PAGE_SIZE - first_page_][index % PAGE_SIZE];
+}
@@ -0,0 +1,21 @@
+#include "document_matches.h"
+
+size_t DocumentMatches::size() const noexcept {
+    return document_ids_.size();
+}
+
+bool DocumentMatches::empty() const noexcept {
+    return document_ids_.empty();
+}
+
+int DocumentMatches::GetDocumentId(size_t index) const {
+    return document_ids_.at(index);
+}
+
+DocumentStatus DocumentMatches::GetStatus(size_t index) const {
+    return statuses_.at(index);
+}
+
+DocumentMatches::WordRange DocumentMatches::GetWords(size_t index) const {
+    return WordRange(words_.begin() + word_offsets_.at(index), words_.begin() + word_offsets_.at(index + 1));
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "document.h"
+#include "paginator.h"
+
+#include <string_view>
+#include <vector>
+
+// Result of SearchServer::MatchDocuments: the matched words of every document are kept
+// in one buffer, in the order the document ids were requested.
+class DocumentMatches {
+public:
+    using WordRange = IteratorRange<std::vector<std::string_view>::const_iterator>;
+
+    size_t size() const noexcept;
+    bool empty() const noexcept;
+
+    int GetDocumentId(size_t index) const;
+    DocumentStatus GetStatus(size_t index) const;
+    WordRange GetWords(size_t index) const;
+
+private:
+    friend class SearchServer;
+
+    std::vector<int> document_ids_;
+    std::vector<DocumentStatus> statuses_;
+    std::vector<size_t> word_offsets_;
+    std::vector<std::string_view> words_;
+};
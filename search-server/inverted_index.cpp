@@ -0,0 +1,226 @@
+#include "inverted_index.h"
+#include "mapped_terms.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+InvertedIndex::InvertedIndex() = default;
+InvertedIndex::~InvertedIndex() = default;
+InvertedIndex::InvertedIndex(InvertedIndex&&) noexcept = default;
+InvertedIndex& InvertedIndex::operator=(InvertedIndex&&) noexcept = default;
+
+void InvertedIndex::MapTerms(std::unique_ptr<MappedTerms> mapped_terms) {
+    if (!terms_.empty() || mapped_terms_) {
+        throw std::logic_error("terms can only be mapped into an empty index"s);
+    }
+    mapped_terms_ = std::move(mapped_terms);
+}
+
+bool InvertedIndex::IsMappedTermId(TermId term_id) const noexcept {
+    return mapped_terms_ && term_id >= FIRST_MAPPED_TERM && term_id - FIRST_MAPPED_TERM < mapped_terms_->size();
+}
+
+const InvertedIndex::PostingList* InvertedIndex::Find(std::string_view term) const {
+    if (const auto it = term_to_id_.find(term); it != term_to_id_.end()) {
+        return &postings_[it->second];
+    }
+    if (mapped_terms_) {
+        if (const uint32_t index = mapped_terms_->Find(term); index != NO_TERM) {
+            const PostingList& postings = mapped_terms_->GetPostings(index);
+            return postings.empty() ? nullptr : &postings;
+        }
+    }
+    return nullptr;
+}
+
+InvertedIndex::TermId InvertedIndex::FindTermId(std::string_view term) const {
+    if (const auto it = term_to_id_.find(term); it != term_to_id_.end()) {
+        return it->second;
+    }
+    if (mapped_terms_) {
+        if (const uint32_t index = mapped_terms_->Find(term); index != NO_TERM && mapped_terms_->IsLive(index)) {
+            return FIRST_MAPPED_TERM + index;
+        }
+    }
+    return NO_TERM;
+}
+
+InvertedIndex::TermId InvertedIndex::AddTerm(std::string_view term) {
+    if (const auto it = term_to_id_.find(term); it != term_to_id_.end()) {
+        return it->second;
+    }
+    // A released mapped term comes back under its old id once it gets a posting.
+    if (mapped_terms_) {
+        if (const uint32_t index = mapped_terms_->Find(term); index != NO_TERM) {
+            return FIRST_MAPPED_TERM + index;
+        }
+    }
+
+    TermId term_id = static_cast<TermId>(postings_.size());
+    if (free_term_ids_.empty()) {
+        if (postings_.size() >= FIRST_MAPPED_TERM) {
+            throw std::length_error("too many terms"s);
+        }
+        terms_.push_back(std::make_unique<std::string>(term));
+        postings_.emplace_back();
+    }
+    else {
+        term_id = free_term_ids_.back();
+        free_term_ids_.pop_back();
+        terms_[term_id] = std::make_unique<std::string>(term);
+    }
+    term_to_id_.emplace(*terms_[term_id], term_id);
+    return term_id;
+}
+
+std::string_view InvertedIndex::GetTerm(TermId term_id) const {
+    if (IsMappedTermId(term_id)) {
+        return mapped_terms_->GetTerm(term_id - FIRST_MAPPED_TERM);
+    }
+    return *terms_.at(term_id);
+}
+
+const InvertedIndex::PostingList& InvertedIndex::GetPostings(TermId term_id) const {
+    if (IsMappedTermId(term_id)) {
+        return mapped_terms_->GetPostings(term_id - FIRST_MAPPED_TERM);
+    }
+    return postings_.at(term_id);
+}
+
+void InvertedIndex::AddPosting(TermId term_id, Posting posting, uint32_t document_length) {
+    PostingList& postings = GetMutablePostings(term_id);
+    postings.RaiseMaxTermFreq(ComputeTermFreq(posting.term_count, document_length));
+    postings.Insert(posting);
+}
+
+void InvertedIndex::RemovePosting(TermId term_id, int document_id) {
+    PostingList& postings = GetMutablePostings(term_id);
+    postings.Erase(document_id);
+    if (postings.empty()) {
+        ReleaseTerm(term_id);
+    }
+}
+
+std::vector<InvertedIndex::TermId> InvertedIndex::Compact() {
+    std::vector<std::unique_ptr<std::string>> terms;
+    std::vector<PostingList> postings;
+    std::unordered_map<std::string_view, TermId> term_to_id;
+    std::vector<TermId> new_term_ids(terms_.size(), NO_TERM);
+    terms.reserve(term_to_id_.size());
+    postings.reserve(term_to_id_.size());
+    term_to_id.reserve(term_to_id_.size());
+
+    for (TermId term_id = 0; term_id < terms_.size(); ++term_id) {
+        if (!terms_[term_id]) {
+            continue;
+        }
+        new_term_ids[term_id] = static_cast<TermId>(terms.size());
+        term_to_id.emplace(*terms_[term_id], new_term_ids[term_id]);
+        terms.push_back(std::move(terms_[term_id]));
+        postings.push_back(std::move(postings_[term_id]));
+        postings.back().ShrinkToFit();
+    }
+
+    terms_ = std::move(terms);
+    postings_ = std::move(postings);
+    term_to_id_ = std::move(term_to_id);
+    free_term_ids_.clear();
+    free_term_ids_.shrink_to_fit();
+    if (mapped_terms_) {
+        mapped_terms_->ShrinkToFit();
+    }
+    return new_term_ids;
+}
+
+void InvertedIndex::ErasePostings(PostingList& postings, const TermPosting* first, const TermPosting* last) {
+    std::vector<Posting> decoded = postings.Decode();
+    size_t size = 0;
+    for (const Posting& posting : decoded) {
+        while (first != last && first->document_id < posting.document_id) {
+            ++first;
+        }
+        if (first == last || first->document_id != posting.document_id) {
+            decoded[size++] = posting;
+        }
+    }
+    decoded.resize(size);
+    postings.Assign(decoded);
+}
+
+InvertedIndex::PostingList& InvertedIndex::GetMutablePostings(TermId term_id) {
+    if (IsMappedTermId(term_id)) {
+        return mapped_terms_->GetMutablePostings(term_id - FIRST_MAPPED_TERM);
+    }
+    return postings_.at(term_id);
+}
+
+void InvertedIndex::ReleaseTerm(TermId term_id) {
+    if (IsMappedTermId(term_id)) {
+        mapped_terms_->Release(term_id - FIRST_MAPPED_TERM);
+        return;
+    }
+    term_to_id_.erase(*terms_[term_id]);
+    terms_[term_id].reset();
+    postings_[term_id] = PostingList{};
+    free_term_ids_.push_back(term_id);
+}
+
+void InvertedIndex::MergePostings(PostingList& postings, const TermPosting* first, const TermPosting* last) {
+    std::vector<Posting> added;
+    added.reserve(last - first);
+    for (; first != last; ++first) {
+        added.push_back({ first->document_id, first->term_count });
+        postings.RaiseMaxTermFreq(ComputeTermFreq(first->term_count, first->document_length));
+    }
+    if (postings.empty() || postings.GetLastDocumentId() < added.front().document_id) {
+        postings.Append(added.data(), added.data() + added.size());
+        return;
+    }
+
+    const std::vector<Posting> old_postings = postings.Decode();
+    std::vector<Posting> merged(old_postings.size() + added.size());
+    std::merge(old_postings.begin(), old_postings.end(), added.begin(), added.end(), merged.begin(), [](const Posting& lhs, const Posting& rhs) {
+        return lhs.document_id < rhs.document_id;
+    });
+    postings.Assign(merged);
+}
+
+size_t InvertedIndex::GetTermCount() const noexcept {
+    return term_to_id_.size() + (mapped_terms_ ? mapped_terms_->GetLiveCount() : 0);
+}
+
+size_t InvertedIndex::GetPostingCount() const noexcept {
+    size_t count = mapped_terms_ ? mapped_terms_->GetPostingCount() : 0;
+    for (const PostingList& postings : postings_) {
+        count += postings.size();
+    }
+    return count;
+}
+
+size_t InvertedIndex::GetPostingMemoryUsage() const noexcept {
+    size_t bytes = mapped_terms_ ? mapped_terms_->GetPostingMemoryUsage() : 0;
+    for (const PostingList& postings : postings_) {
+        bytes += postings.GetMemoryUsage();
+    }
+    return bytes;
+}
+
+size_t InvertedIndex::GetMemoryUsage() const noexcept {
+    size_t bytes = sizeof(*this);
+    bytes += terms_.capacity() * sizeof(std::unique_ptr<std::string>);
+    for (const auto& term : terms_) {
+        if (term) {
+            bytes += sizeof(std::string) + (term->capacity() > 15 ? term->capacity() + 1 : 0);
+        }
+    }
+    bytes += term_to_id_.bucket_count() * sizeof(void*);
+    bytes += term_to_id_.size() * (sizeof(std::string_view) + sizeof(TermId) + 2 * sizeof(void*));
+    bytes += postings_.capacity() * sizeof(PostingList);
+    bytes += free_term_ids_.capacity() * sizeof(TermId);
+    if (mapped_terms_) {
+        bytes += mapped_terms_->GetMemoryUsage();
+    }
+    return bytes + GetPostingMemoryUsage();
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "parallel_algorithms.h"
+#include "posting_list.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class MappedTerms;
+
+class InvertedIndex {
+public:
+    using TermId = uint32_t;
+    static constexpr TermId NO_TERM = UINT32_MAX;
+    // Terms of a mapped snapshot take the ids from here on, in dictionary order; terms
+    // added in memory take the ids below it.
+    static constexpr TermId FIRST_MAPPED_TERM = TermId{ 1 } << 31;
+
+    using PostingList = ::PostingList;
+
+    // A posting on its way into the index. The document length is not stored with it; it
+    // only raises the bound of the term's frequencies.
+    struct TermPosting {
+        TermId term_id;
+        int document_id;
+        uint32_t term_count;
+        uint32_t document_length;
+    };
+
+    // Entry of a document's forward index; a document keeps them sorted by term id and
+    // stores its length once, so the entry holds the raw count instead of a frequency.
+    struct TermFrequency {
+        TermId term_id;
+        uint32_t term_count;
+    };
+
+    InvertedIndex();
+    ~InvertedIndex();
+    InvertedIndex(InvertedIndex&&) noexcept;
+    InvertedIndex& operator=(InvertedIndex&&) noexcept;
+
+    // Serves the terms of a mapped snapshot alongside the ones added in memory; the index
+    // must be empty. Reading a mapped term decodes its postings on first use, and changing
+    // them works on that copy.
+    void MapTerms(std::unique_ptr<MappedTerms> mapped_terms);
+    bool IsMappedTermId(TermId term_id) const noexcept;
+
+    const PostingList* Find(std::string_view term) const;
+    // NO_TERM if the term is not indexed.
+    TermId FindTermId(std::string_view term) const;
+
+    TermId AddTerm(std::string_view term);
+    std::string_view GetTerm(TermId term_id) const;
+    const PostingList& GetPostings(TermId term_id) const;
+    void AddPosting(TermId term_id, Posting posting, uint32_t document_length);
+    void RemovePosting(TermId term_id, int document_id);
+
+    template <typename ExecutionPolicy>
+    void AddPostings(ExecutionPolicy&& policy, std::vector<TermPosting> postings);
+
+    template <typename ExecutionPolicy>
+    void RemovePostings(ExecutionPolicy&& policy, const std::vector<TermId>& term_ids, int document_id);
+
+    // Removes many documents at once: every affected posting list is rewritten in one
+    // pass. Term counts and lengths of the given postings are ignored.
+    template <typename ExecutionPolicy>
+    void RemovePostings(ExecutionPolicy&& policy, std::vector<TermPosting> postings);
+
+    // Renumbers live terms densely and releases spare capacity left by removals. Returns
+    // the new id of every old id (NO_TERM for released ones); the renumbering keeps the
+    // relative order of ids. Mapped terms keep their ids and are not in the result.
+    std::vector<TermId> Compact();
+
+    // Calls function(term_id, term, postings) for every live term.
+    template <typename Function>
+    void ForEachTerm(Function function) const;
+
+    size_t GetTermCount() const noexcept;
+    size_t GetPostingCount() const noexcept;
+    // Heap bytes held by the posting lists, without their fixed-size headers.
+    size_t GetPostingMemoryUsage() const noexcept;
+    size_t GetMemoryUsage() const noexcept;
+
+private:
+    // Sorts postings by term and document and returns where each term's run begins,
+    // followed by postings.size().
+    template <typename ExecutionPolicy>
+    static std::vector<size_t> GroupByTerm(ExecutionPolicy&& policy, std::vector<TermPosting>& postings);
+
+    void MergePostings(PostingList& postings, const TermPosting* first, const TermPosting* last);
+    static void ErasePostings(PostingList& postings, const TermPosting* first, const TermPosting* last);
+    // Copies a mapped term's postings out of the snapshot the first time it changes.
+    PostingList& GetMutablePostings(TermId term_id);
+    void ReleaseTerm(TermId term_id);
+
+    // A term lives while it has postings. Each term string is allocated separately, so views
+    // into it stay valid until the term is released, even across Compact.
+    std::vector<std::unique_ptr<std::string>> terms_;
+    std::unordered_map<std::string_view, TermId> term_to_id_;
+    std::vector<PostingList> postings_;
+    std::vector<TermId> free_term_ids_;
+    std::unique_ptr<MappedTerms> mapped_terms_;
+};
+
+template <typename ExecutionPolicy>
+std::vector<size_t> InvertedIndex::GroupByTerm(ExecutionPolicy&& policy, std::vector<TermPosting>& postings) {
+    Sort(policy, postings.begin(), postings.end(), [](const TermPosting& lhs, const TermPosting& rhs) {
+        return lhs.term_id < rhs.term_id || (lhs.term_id == rhs.term_id && lhs.document_id < rhs.document_id);
+    });
+
+    std::vector<size_t> run_begins;
+    for (size_t i = 0; i < postings.size(); ++i) {
+        if (i == 0 || postings[i].term_id != postings[i - 1].term_id) {
+            run_begins.push_back(i);
+        }
+    }
+    run_begins.push_back(postings.size());
+    return run_begins;
+}
+
+template <typename ExecutionPolicy>
+void InvertedIndex::AddPostings(ExecutionPolicy&& policy, std::vector<TermPosting> postings) {
+    const std::vector<size_t> run_begins = GroupByTerm(policy, postings);
+
+    // Mapped terms are copied out one at a time before the runs are merged in parallel.
+    std::vector<PostingList*> lists(run_begins.size() - 1);
+    for (size_t run = 0; run < lists.size(); ++run) {
+        lists[run] = &GetMutablePostings(postings[run_begins[run]].term_id);
+    }
+
+    std::vector<size_t> runs(lists.size());
+    std::iota(runs.begin(), runs.end(), 0);
+    ForEach(policy, runs.begin(), runs.end(), [this, &postings, &run_begins, &lists](size_t run) {
+        MergePostings(*lists[run], postings.data() + run_begins[run], postings.data() + run_begins[run + 1]);
+    });
+}
+
+template <typename ExecutionPolicy>
+void InvertedIndex::RemovePostings(ExecutionPolicy&& policy, const std::vector<TermId>& term_ids, int document_id) {
+    std::vector<PostingList*> lists(term_ids.size());
+    for (size_t i = 0; i < term_ids.size(); ++i) {
+        lists[i] = &GetMutablePostings(term_ids[i]);
+    }
+
+    ForEach(policy, lists.begin(), lists.end(), [document_id](PostingList* list) {
+        list->Erase(document_id);
+    });
+
+    for (size_t i = 0; i < term_ids.size(); ++i) {
+        if (lists[i]->empty()) {
+            ReleaseTerm(term_ids[i]);
+        }
+    }
+}
+
+template <typename ExecutionPolicy>
+void InvertedIndex::RemovePostings(ExecutionPolicy&& policy, std::vector<TermPosting> postings) {
+    const std::vector<size_t> run_begins = GroupByTerm(policy, postings);
+
+    std::vector<PostingList*> lists(run_begins.size() - 1);
+    for (size_t run = 0; run < lists.size(); ++run) {
+        lists[run] = &GetMutablePostings(postings[run_begins[run]].term_id);
+    }
+
+    std::vector<size_t> runs(lists.size());
+    std::iota(runs.begin(), runs.end(), 0);
+    ForEach(policy, runs.begin(), runs.end(), [&postings, &run_begins, &lists](size_t run) {
+        ErasePostings(*lists[run], postings.data() + run_begins[run], postings.data() + run_begins[run + 1]);
+    });
+
+    for (size_t run = 0; run < lists.size(); ++run) {
+        if (lists[run]->empty()) {
+            ReleaseTerm(postings[run_begins[run]].term_id);
+        }
+    }
+}
+
+template <typename Function>
+void InvertedIndex::ForEachTerm(Function function) const {
+    for (TermId term_id = 0; term_id < postings_.size(); ++term_id) {
+        if (terms_[term_id]) {
+            function(term_id, std::string_view(*terms_[term_id]), postings_[term_id]);
+        }
+    }
+    for (TermId term_id = FIRST_MAPPED_TERM; IsMappedTermId(term_id); ++term_id) {
+        const PostingList& postings = GetPostings(term_id);
+        if (!postings.empty()) {
+            function(term_id, GetTerm(term_id), postings);
+        }
+    }
+}
@@ -0,0 +1,192 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+constexpr size_t OPERATION_COUNT = 2;
+constexpr size_t STAGE_COUNT = 5;
+
+struct ThreadHistograms {
+    std::array<std::array<LatencyHistogram, STAGE_COUNT>, OPERATION_COUNT> histograms;
+
+    void AddTo(ThreadHistograms& other) const noexcept {
+        for (size_t operation = 0; operation < OPERATION_COUNT; ++operation) {
+            for (size_t stage = 0; stage < STAGE_COUNT; ++stage) {
+                histograms[operation][stage].AddTo(other.histograms[operation][stage]);
+            }
+        }
+    }
+
+    void Reset() noexcept {
+        for (auto& operation_histograms : histograms) {
+            for (auto& histogram : operation_histograms) {
+                histogram.Reset();
+            }
+        }
+    }
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadHistograms*> threads;
+    // Counts of threads that have exited.
+    ThreadHistograms retired;
+};
+
+// Never destroyed, so threads that exit after main returns can still retire their counts.
+Registry& GetRegistry() {
+    static Registry* const registry = new Registry;
+    return *registry;
+}
+
+#ifndef SEARCH_SERVER_DISABLE_METRICS
+// Registers the histograms of a thread on its first recording. When the thread exits,
+// its counts are merged into the retired totals and the histograms are freed, so threads
+// that come and go do not accumulate histograms.
+class ThreadRegistration {
+public:
+    ThreadRegistration() : histograms_(std::make_unique<ThreadHistograms>()) {
+        Registry& registry = GetRegistry();
+        std::lock_guard guard(registry.mutex);
+        registry.threads.push_back(histograms_.get());
+    }
+
+    ~ThreadRegistration() {
+        Registry& registry = GetRegistry();
+        std::lock_guard guard(registry.mutex);
+        histograms_->AddTo(registry.retired);
+        registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), histograms_.get()));
+    }
+
+    ThreadRegistration(const ThreadRegistration&) = delete;
+    ThreadRegistration& operator=(const ThreadRegistration&) = delete;
+
+    ThreadHistograms& GetHistograms() noexcept {
+        return *histograms_;
+    }
+
+private:
+    const std::unique_ptr<ThreadHistograms> histograms_;
+};
+
+ThreadHistograms& GetThreadHistograms() {
+    thread_local ThreadRegistration registration;
+    return registration.GetHistograms();
+}
+#endif
+
+}
+
+// Only the owning thread writes, so an increment needs no read-modify-write; atomics only
+// keep concurrent snapshots well-defined.
+void LatencyHistogram::Record(std::chrono::nanoseconds duration) noexcept {
+    std::atomic<uint64_t>& count = counts_[GetBucket(std::max<int64_t>(0, duration.count()))];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::AddTo(LatencyHistogram& other) const noexcept {
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        if (const uint64_t count = counts_[bucket].load(std::memory_order_relaxed); count > 0) {
+            std::atomic<uint64_t>& other_count = other.counts_[bucket];
+            other_count.store(other_count.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        }
+    }
+}
+
+void LatencyHistogram::Reset() noexcept {
+    for (auto& count : counts_) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+LatencySnapshot LatencyHistogram::GetSnapshot() const noexcept {
+    std::array<uint64_t, BUCKET_COUNT> counts;
+    LatencySnapshot snapshot;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        counts[bucket] = counts_[bucket].load(std::memory_order_relaxed);
+        snapshot.count += counts[bucket];
+    }
+    if (snapshot.count == 0) {
+        return snapshot;
+    }
+
+    const auto percentile = [&counts, &snapshot](double fraction) {
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * snapshot.count + 0.5));
+        uint64_t seen = 0;
+        for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+            seen += counts[bucket];
+            if (seen >= rank) {
+                return std::chrono::nanoseconds(GetBucketUpperBound(bucket));
+            }
+        }
+        return std::chrono::nanoseconds(GetBucketUpperBound(BUCKET_COUNT - 1));
+    };
+    snapshot.p50 = percentile(0.5);
+    snapshot.p99 = percentile(0.99);
+    snapshot.p999 = percentile(0.999);
+    snapshot.max = percentile(1.0);
+    return snapshot;
+}
+
+size_t LatencyHistogram::GetBucket(uint64_t value) noexcept {
+    constexpr uint64_t SUB_BUCKET_COUNT = uint64_t{1} << SUB_BUCKET_BITS;
+    if (value < SUB_BUCKET_COUNT) {
+        return value;
+    }
+    const int exponent = std::min(63 - __builtin_clzll(value), MAX_EXPONENT);
+    const uint64_t sub_bucket = std::min(value >> (exponent - SUB_BUCKET_BITS), 2 * SUB_BUCKET_COUNT - 1) - SUB_BUCKET_COUNT;
+    return (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT + sub_bucket;
+}
+
+uint64_t LatencyHistogram::GetBucketUpperBound(size_t bucket) noexcept {
+    constexpr uint64_t SUB_BUCKET_COUNT = uint64_t{1} << SUB_BUCKET_BITS;
+    if (bucket < SUB_BUCKET_COUNT) {
+        return bucket;
+    }
+    const int exponent = static_cast<int>(bucket / SUB_BUCKET_COUNT) + SUB_BUCKET_BITS - 1;
+    const uint64_t sub_bucket = bucket % SUB_BUCKET_COUNT;
+    return ((SUB_BUCKET_COUNT + sub_bucket + 1) << (exponent - SUB_BUCKET_BITS)) - 1;
+}
+
+#ifndef SEARCH_SERVER_DISABLE_METRICS
+void RecordLatency(SearchOperation operation, SearchStage stage, std::chrono::nanoseconds duration) {
+    GetThreadHistograms().histograms[static_cast<size_t>(operation)][static_cast<size_t>(stage)].Record(duration);
+}
+#endif
+
+LogDuration::Clock::duration GetClockOverhead() {
+    using Clock = LogDuration::Clock;
+    Clock::duration overhead = Clock::duration::max();
+    for (int i = 0; i < 100; ++i) {
+        const auto start_time = Clock::now();
+        overhead = std::min(overhead, Clock::now() - start_time);
+    }
+    return overhead;
+}
+
+LatencySnapshot GetLatencySnapshot(SearchOperation operation, SearchStage stage) {
+    const auto get_histogram = [operation, stage](const ThreadHistograms& histograms) -> const LatencyHistogram& {
+        return histograms.histograms[static_cast<size_t>(operation)][static_cast<size_t>(stage)];
+    };
+    LatencyHistogram total;
+    Registry& registry = GetRegistry();
+    std::lock_guard guard(registry.mutex);
+    get_histogram(registry.retired).AddTo(total);
+    for (const ThreadHistograms* histograms : registry.threads) {
+        get_histogram(*histograms).AddTo(total);
+    }
+    return total.GetSnapshot();
+}
+
+void ResetLatencyHistograms() {
+    Registry& registry = GetRegistry();
+    std::lock_guard guard(registry.mutex);
+    registry.retired.Reset();
+    for (ThreadHistograms* histograms : registry.threads) {
+        histograms->Reset();
+    }
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include "log_duration.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+enum class SearchOperation {
+    FIND_TOP_DOCUMENTS,
+    MATCH_DOCUMENT,
+};
+
+enum class SearchStage {
+    PARSE,
+    TRAVERSAL,
+    FILTER,
+    TOP_K,
+    RESULT,
+};
+
+struct LatencySnapshot {
+    uint64_t count = 0;
+    std::chrono::nanoseconds p50{};
+    std::chrono::nanoseconds p99{};
+    std::chrono::nanoseconds p999{};
+    std::chrono::nanoseconds max{};
+};
+
+// Log-linear histogram in the spirit of HdrHistogram: every power of two is split into
+// 16 linear buckets, so recorded values keep about 6% precision. Record and AddTo assume
+// a single writer; any thread may read.
+class LatencyHistogram {
+public:
+    void Record(std::chrono::nanoseconds duration) noexcept;
+    void AddTo(LatencyHistogram& other) const noexcept;
+    void Reset() noexcept;
+
+    LatencySnapshot GetSnapshot() const noexcept;
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int MAX_EXPONENT = 40;
+    static constexpr size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) << SUB_BUCKET_BITS;
+
+    static size_t GetBucket(uint64_t value) noexcept;
+    static uint64_t GetBucketUpperBound(size_t bucket) noexcept;
+
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> counts_{};
+};
+
+// Every thread records into its own histograms; snapshots merge all threads, including
+// ones that have already exited, whose counts are kept in one retired total.
+LatencySnapshot GetLatencySnapshot(SearchOperation operation, SearchStage stage);
+// Counts recorded by other threads while the reset runs may survive it.
+void ResetLatencyHistograms();
+
+// Cost of one clock read, measured once; subtracted from sampled intervals.
+LogDuration::Clock::duration GetClockOverhead();
+
+#ifndef SEARCH_SERVER_DISABLE_METRICS
+
+void RecordLatency(SearchOperation operation, SearchStage stage, std::chrono::nanoseconds duration);
+
+class StageTimer {
+public:
+    using Clock = LogDuration::Clock;
+
+    StageTimer(SearchOperation operation, SearchStage stage) : operation_(operation), stage_(stage) {}
+
+    ~StageTimer() {
+        RecordLatency(operation_, stage_, Clock::now() - start_time_);
+    }
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    const Clock::time_point start_time_ = Clock::now();
+    const SearchOperation operation_;
+    const SearchStage stage_;
+};
+
+// Splits the scoring loop into filter and top-K time. Reading the clock for every candidate
+// would cost more than filtering it, so only every SAMPLE_PERIOD-th candidate is timed and
+// the totals are scaled by the number of candidates seen.
+class CandidateSampler {
+public:
+    using Clock = LogDuration::Clock;
+
+    void StartFilter() noexcept {
+        is_sampled_ = candidate_count_++ % SAMPLE_PERIOD == 0;
+        if (is_sampled_) {
+            ++sampled_count_;
+            mark_ = Clock::now();
+        }
+    }
+
+    void FinishFilter() noexcept {
+        if (is_sampled_) {
+            filter_time_ += Measure();
+        }
+    }
+
+    void StartTopK() noexcept {
+        if (is_sampled_) {
+            mark_ = Clock::now();
+        }
+    }
+
+    void FinishTopK() noexcept {
+        if (is_sampled_) {
+            top_k_time_ += Measure();
+        }
+    }
+
+    void Merge(const CandidateSampler& other) noexcept {
+        candidate_count_ += other.candidate_count_;
+        sampled_count_ += other.sampled_count_;
+        filter_time_ += other.filter_time_;
+        top_k_time_ += other.top_k_time_;
+    }
+
+    std::chrono::nanoseconds GetFilterTime() const noexcept {
+        return Scale(filter_time_);
+    }
+
+    std::chrono::nanoseconds GetTopKTime() const noexcept {
+        return Scale(top_k_time_);
+    }
+
+private:
+    static constexpr uint64_t SAMPLE_PERIOD = 16;
+
+    Clock::duration Measure() const noexcept {
+        static const Clock::duration clock_overhead = GetClockOverhead();
+        return std::max(Clock::duration{}, Clock::now() - mark_ - clock_overhead);
+    }
+
+    std::chrono::nanoseconds Scale(Clock::duration time) const noexcept {
+        if (sampled_count_ == 0) {
+            return {};
+        }
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time) * candidate_count_ / sampled_count_;
+    }
+
+    uint64_t candidate_count_ = 0;
+    uint64_t sampled_count_ = 0;
+    bool is_sampled_ = false;
+    Clock::time_point mark_;
+    Clock::duration filter_time_{};
+    Clock::duration top_k_time_{};
+};
+
+// Records one scoring pass: filter and top-K time come from the sampler and traversal is
+// the rest of the pass. Filter and top-K time of a parallel pass are summed over workers,
+// so there traversal is the wall time of the whole pass.
+class ScoringTimer {
+public:
+    using Clock = LogDuration::Clock;
+
+    ScoringTimer(SearchOperation operation, bool is_parallel) : operation_(operation), is_parallel_(is_parallel) {}
+
+    ~ScoringTimer() {
+        const std::chrono::nanoseconds filter_time = sampler_.GetFilterTime();
+        const std::chrono::nanoseconds top_k_time = sampler_.GetTopKTime();
+        std::chrono::nanoseconds traversal_time = Clock::now() - start_time_;
+        if (!is_parallel_) {
+            traversal_time = std::max(std::chrono::nanoseconds{}, traversal_time - filter_time - top_k_time);
+        }
+        RecordLatency(operation_, SearchStage::TRAVERSAL, traversal_time);
+        RecordLatency(operation_, SearchStage::FILTER, filter_time);
+        RecordLatency(operation_, SearchStage::TOP_K, top_k_time);
+    }
+
+    ScoringTimer(const ScoringTimer&) = delete;
+    ScoringTimer& operator=(const ScoringTimer&) = delete;
+
+    CandidateSampler& GetSampler() noexcept {
+        return sampler_;
+    }
+
+private:
+    const Clock::time_point start_time_ = Clock::now();
+    const SearchOperation operation_;
+    const bool is_parallel_;
+    CandidateSampler sampler_;
+};
+
+#define SEARCH_STAGE_TIMER(operation, stage) StageTimer UNIQUE_VAR_NAME_PROFILE(operation, stage)
+
+#else
+
+inline void RecordLatency(SearchOperation, SearchStage, std::chrono::nanoseconds) {}
+
+class CandidateSampler {
+public:
+    void StartFilter() noexcept {}
+    void FinishFilter() noexcept {}
+    void StartTopK() noexcept {}
+    void FinishTopK() noexcept {}
+    void Merge(const CandidateSampler&) noexcept {}
+    std::chrono::nanoseconds GetFilterTime() const noexcept { return {}; }
+    std::chrono::nanoseconds GetTopKTime() const noexcept { return {}; }
+};
+
+class ScoringTimer {
+public:
+    ScoringTimer(SearchOperation, bool) {}
+
+    CandidateSampler& GetSampler() noexcept {
+        return sampler_;
+    }
+
+private:
+    CandidateSampler sampler_;
+};
+
+#define SEARCH_STAGE_TIMER(operation, stage)
+
+#endif
@@ -5,6 +5,7 @@
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -29,7 +30,7 @@ public:
 
         const auto end_time = Clock::now();
         const auto dur = end_time - start_time_;
-        os_ << "Operation time: "s << std::chrono::duration_cast<std::chrono::microseconds>(dur).count() << " mcs"s << std::endl;
+        os_ << (operation_name_.empty() ? "Operation time"s : operation_name_) << ": "s << std::chrono::duration_cast<std::chrono::microseconds>(dur).count() << " mcs"s << std::endl;
     }
 
 private:
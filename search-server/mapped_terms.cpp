@@ -0,0 +1,178 @@
+#include "mapped_terms.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+MappedTerms::MappedTerms(std::shared_ptr<const MappedFile> file, ArrayView<SnapshotTermRecord> terms, std::string_view term_text, ArrayView<Posting> postings,
+    ArrayView<SnapshotDocumentRecord> documents, ArrayView<InvertedIndex::TermFrequency> forward_index)
+    : file_(std::move(file))
+    , terms_(terms)
+    , term_text_(term_text)
+    , postings_(postings)
+    , documents_(documents)
+    , forward_index_(forward_index) {
+    if (terms_.size() > InvertedIndex::NO_TERM - InvertedIndex::FIRST_MAPPED_TERM) {
+        throw std::runtime_error("snapshot dictionary is corrupted");
+    }
+    lists_ = std::make_unique<std::atomic<PostingList*>[]>(terms_.size());
+}
+
+MappedTerms::~MappedTerms() {
+    for (size_t index = 0; index < terms_.size(); ++index) {
+        delete lists_[index].load(std::memory_order_relaxed);
+    }
+}
+
+size_t MappedTerms::size() const noexcept {
+    return terms_.size();
+}
+
+size_t MappedTerms::GetLiveCount() const noexcept {
+    return terms_.size() - released_count_;
+}
+
+uint32_t MappedTerms::Find(std::string_view term) const {
+    uint32_t first = 0;
+    uint32_t last = static_cast<uint32_t>(terms_.size());
+    while (first < last) {
+        const uint32_t middle = first + (last - first) / 2;
+        if (GetTerm(middle) < term) {
+            first = middle + 1;
+        }
+        else {
+            last = middle;
+        }
+    }
+    return first < terms_.size() && GetTerm(first) == term ? first : InvertedIndex::NO_TERM;
+}
+
+std::string_view MappedTerms::GetTerm(uint32_t index) const {
+    const SnapshotTermRecord record = GetRecord(index);
+    return term_text_.substr(record.term_offset, record.term_size);
+}
+
+bool MappedTerms::IsLive(uint32_t index) const noexcept {
+    // Decoded lists are never empty until released.
+    const PostingList* list = lists_[index].load(std::memory_order_acquire);
+    return list == nullptr || !list->empty();
+}
+
+const PostingList& MappedTerms::GetPostings(uint32_t index) const {
+    std::atomic<PostingList*>& slot = lists_[index];
+    PostingList* list = slot.load(std::memory_order_acquire);
+    if (list == nullptr) {
+        // Threads that read the term at once each decode it; the first one to finish wins.
+        std::unique_ptr<PostingList> decoded = Decode(index);
+        if (slot.compare_exchange_strong(list, decoded.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+            list = decoded.release();
+        }
+    }
+    return *list;
+}
+
+PostingList& MappedTerms::GetMutablePostings(uint32_t index) {
+    std::atomic<PostingList*>& slot = lists_[index];
+    PostingList* list = slot.load(std::memory_order_relaxed);
+    if (list == nullptr) {
+        list = Decode(index).release();
+        slot.store(list, std::memory_order_relaxed);
+    }
+    else if (list->empty()) {
+        --released_count_;
+    }
+    return *list;
+}
+
+void MappedTerms::Release(uint32_t index) {
+    *lists_[index].load(std::memory_order_relaxed) = PostingList{};
+    ++released_count_;
+}
+
+void MappedTerms::ShrinkToFit() {
+    for (size_t index = 0; index < terms_.size(); ++index) {
+        if (PostingList* list = lists_[index].load(std::memory_order_relaxed)) {
+            list->ShrinkToFit();
+        }
+    }
+}
+
+size_t MappedTerms::GetPostingCount() const noexcept {
+    size_t count = 0;
+    for (size_t index = 0; index < terms_.size(); ++index) {
+        const PostingList* list = lists_[index].load(std::memory_order_acquire);
+        count += list != nullptr ? list->size() : terms_[index].posting_count;
+    }
+    return count;
+}
+
+size_t MappedTerms::GetPostingMemoryUsage() const noexcept {
+    size_t bytes = 0;
+    for (size_t index = 0; index < terms_.size(); ++index) {
+        if (const PostingList* list = lists_[index].load(std::memory_order_acquire)) {
+            bytes += list->GetMemoryUsage();
+        }
+    }
+    return bytes;
+}
+
+size_t MappedTerms::GetMemoryUsage() const noexcept {
+    size_t bytes = sizeof(*this) + terms_.size() * sizeof(std::atomic<PostingList*>);
+    for (size_t index = 0; index < terms_.size(); ++index) {
+        if (lists_[index].load(std::memory_order_acquire) != nullptr) {
+            bytes += sizeof(PostingList);
+        }
+    }
+    return bytes;
+}
+
+SnapshotTermRecord MappedTerms::GetRecord(uint32_t index) const {
+    if (index >= terms_.size()) {
+        throw std::out_of_range("term_id out of range"s);
+    }
+    const SnapshotTermRecord& record = terms_[index];
+    if (record.term_offset > term_text_.size() || record.term_size > term_text_.size() - record.term_offset) {
+        throw std::runtime_error("snapshot dictionary is corrupted");
+    }
+    return record;
+}
+
+// Every posting must belong to a document of the snapshot whose forward index lists the
+// term: removing a document copies out each term it lists, so no list read from the file
+// later can name a removed document.
+std::unique_ptr<PostingList> MappedTerms::Decode(uint32_t index) const {
+    const SnapshotTermRecord record = GetRecord(index);
+    if (record.posting_count == 0 || record.postings_offset > postings_.size() || record.posting_count > postings_.size() - record.postings_offset) {
+        throw std::runtime_error("snapshot posting list is corrupted");
+    }
+
+    const InvertedIndex::TermId term_id = InvertedIndex::FIRST_MAPPED_TERM + index;
+    const Posting* first = postings_.data() + record.postings_offset;
+    const Posting* last = first + record.posting_count;
+    const SnapshotDocumentRecord* document = documents_.begin();
+    double max_term_freq = 0.0;
+    for (const Posting* posting = first; posting != last; ++posting) {
+        document = std::lower_bound(document, documents_.end(), posting->document_id, [](const SnapshotDocumentRecord& record, int document_id) {
+            return record.id < document_id;
+        });
+        if (document == documents_.end() || document->id != posting->document_id || (posting != first && posting[-1].document_id >= posting->document_id)
+            || posting->term_count == 0 || posting->term_count > document->length) {
+            throw std::runtime_error("snapshot posting list is corrupted");
+        }
+        const InvertedIndex::TermFrequency* forward_first = forward_index_.data() + document->forward_offset;
+        const InvertedIndex::TermFrequency* forward_last = forward_first + document->forward_size;
+        const auto entry = std::lower_bound(forward_first, forward_last, term_id, [](const InvertedIndex::TermFrequency& entry, InvertedIndex::TermId id) {
+            return entry.term_id < id;
+        });
+        if (entry == forward_last || entry->term_id != term_id) {
+            throw std::runtime_error("snapshot posting list is corrupted");
+        }
+        max_term_freq = std::max(max_term_freq, ComputeTermFreq(posting->term_count, document->length));
+    }
+
+    auto list = std::make_unique<PostingList>();
+    list->Assign(first, last);
+    list->RaiseMaxTermFreq(max_term_freq);
+    return list;
+}
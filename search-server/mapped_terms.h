@@ -0,0 +1,65 @@
+#pragma once
+
+#include "array_view.h"
+#include "inverted_index.h"
+#include "mapped_file.h"
+#include "posting_list.h"
+#include "snapshot.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+// Dictionary and posting lists of a mapped snapshot, read in place. A term is found by
+// bisection over the dictionary; its posting list is checked against the snapshot's
+// documents and encoded the first time it is read, and kept from then on. Changes to a
+// term work on that copy, so terms nobody touches are never read from the file. Reading
+// is safe from several threads while no thread changes the terms.
+class MappedTerms {
+public:
+    // The views must lie in file; documents are the snapshot's, already checked.
+    MappedTerms(std::shared_ptr<const MappedFile> file, ArrayView<SnapshotTermRecord> terms, std::string_view term_text, ArrayView<Posting> postings,
+        ArrayView<SnapshotDocumentRecord> documents, ArrayView<InvertedIndex::TermFrequency> forward_index);
+    ~MappedTerms();
+
+    MappedTerms(const MappedTerms&) = delete;
+    MappedTerms& operator=(const MappedTerms&) = delete;
+
+    // Number of terms in the dictionary, including released ones.
+    size_t size() const noexcept;
+    size_t GetLiveCount() const noexcept;
+
+    // Position of term in the dictionary, or InvertedIndex::NO_TERM.
+    uint32_t Find(std::string_view term) const;
+    std::string_view GetTerm(uint32_t index) const;
+    // False once the term is released; does not decode the postings.
+    bool IsLive(uint32_t index) const noexcept;
+    // Empty once the term is released.
+    const PostingList& GetPostings(uint32_t index) const;
+    // Only called to change the postings; adding to a released term brings it back.
+    PostingList& GetMutablePostings(uint32_t index);
+    // The term's postings must all have been removed.
+    void Release(uint32_t index);
+
+    void ShrinkToFit();
+    size_t GetPostingCount() const noexcept;
+    size_t GetPostingMemoryUsage() const noexcept;
+    // Heap bytes besides those of GetPostingMemoryUsage; the mapping itself is not counted.
+    size_t GetMemoryUsage() const noexcept;
+
+private:
+    SnapshotTermRecord GetRecord(uint32_t index) const;
+    std::unique_ptr<PostingList> Decode(uint32_t index) const;
+
+    std::shared_ptr<const MappedFile> file_;
+    ArrayView<SnapshotTermRecord> terms_;
+    std::string_view term_text_;
+    ArrayView<Posting> postings_;
+    ArrayView<SnapshotDocumentRecord> documents_;
+    ArrayView<InvertedIndex::TermFrequency> forward_index_;
+    // Owned encoded lists, null until first read.
+    std::unique_ptr<std::atomic<PostingList*>[]> lists_;
+    size_t released_count_ = 0;
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "config.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <execution>
+#include <functional>
+#include <iterator>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Algorithms used by the search server under an execution policy. Standard policies are
+// passed to the standard algorithms; a PoolPolicy runs them on its ThreadPool. Pool
+// versions require random access iterators.
+
+template <typename ExecutionPolicy>
+using EnableIfStdPolicy = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>, int>;
+
+// Number of threads the policy may run on.
+template <typename ExecutionPolicy, EnableIfStdPolicy<ExecutionPolicy> = 0>
+size_t GetConcurrency(const ExecutionPolicy& policy) {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+inline size_t GetConcurrency(const PoolPolicy& policy) {
+    return policy.pool.GetWorkerCount() + 1;
+}
+
+template <typename ExecutionPolicy, typename Iterator, typename Function, EnableIfStdPolicy<ExecutionPolicy> = 0>
+void ForEach(ExecutionPolicy&& policy, Iterator first, Iterator last, Function function) {
+    std::for_each(policy, first, last, function);
+}
+
+template <typename Iterator, typename Function>
+void ForEach(const PoolPolicy& policy, Iterator first, Iterator last, Function function) {
+    policy.pool.ParallelFor(last - first, [first, &function](size_t i) {
+        function(first[i]);
+    });
+}
+
+template <typename ExecutionPolicy, typename InputIterator, typename OutputIterator, typename Function, EnableIfStdPolicy<ExecutionPolicy> = 0>
+OutputIterator Transform(ExecutionPolicy&& policy, InputIterator first, InputIterator last, OutputIterator output, Function function) {
+    return std::transform(policy, first, last, output, function);
+}
+
+template <typename InputIterator, typename OutputIterator, typename Function>
+OutputIterator Transform(const PoolPolicy& policy, InputIterator first, InputIterator last, OutputIterator output, Function function) {
+    policy.pool.ParallelFor(last - first, [first, output, &function](size_t i) {
+        output[i] = function(first[i]);
+    });
+    return output + (last - first);
+}
+
+template <typename ExecutionPolicy, typename Iterator, typename Predicate, EnableIfStdPolicy<ExecutionPolicy> = 0>
+bool NoneOf(ExecutionPolicy&& policy, Iterator first, Iterator last, Predicate predicate) {
+    return std::none_of(policy, first, last, predicate);
+}
+
+template <typename Iterator, typename Predicate>
+bool NoneOf(const PoolPolicy& policy, Iterator first, Iterator last, Predicate predicate) {
+    std::atomic<bool> found = false;
+    policy.pool.ParallelFor(last - first, [first, &predicate, &found](size_t i) {
+        if (!found.load(std::memory_order_relaxed) && predicate(first[i])) {
+            found.store(true, std::memory_order_relaxed);
+        }
+    });
+    return !found.load();
+}
+
+template <typename ExecutionPolicy, typename InputIterator, typename OutputIterator, typename Predicate, EnableIfStdPolicy<ExecutionPolicy> = 0>
+OutputIterator CopyIf(ExecutionPolicy&& policy, InputIterator first, InputIterator last, OutputIterator output, Predicate predicate) {
+    return std::copy_if(policy, first, last, output, predicate);
+}
+
+// Predicates are evaluated in parallel; the selected elements are copied in order.
+template <typename InputIterator, typename OutputIterator, typename Predicate>
+OutputIterator CopyIf(const PoolPolicy& policy, InputIterator first, InputIterator last, OutputIterator output, Predicate predicate) {
+    std::vector<char> is_selected(last - first);
+    policy.pool.ParallelFor(is_selected.size(), [first, &predicate, &is_selected](size_t i) {
+        is_selected[i] = predicate(first[i]);
+    });
+    for (size_t i = 0; i < is_selected.size(); ++i) {
+        if (is_selected[i]) {
+            *output++ = first[i];
+        }
+    }
+    return output;
+}
+
+template <typename ExecutionPolicy, typename Iterator, typename Compare, EnableIfStdPolicy<ExecutionPolicy> = 0>
+void Sort(ExecutionPolicy&& policy, Iterator first, Iterator last, Compare compare) {
+    std::sort(policy, first, last, compare);
+}
+
+template <typename ExecutionPolicy, typename Iterator, EnableIfStdPolicy<ExecutionPolicy> = 0>
+void Sort(ExecutionPolicy&& policy, Iterator first, Iterator last) {
+    std::sort(policy, first, last);
+}
+
+// Sorts one chunk per thread, then merges neighbouring chunks pairwise in parallel rounds.
+template <typename Iterator, typename Compare>
+void Sort(const PoolPolicy& policy, Iterator first, Iterator last, Compare compare) {
+    const size_t size = last - first;
+    const size_t chunk_count = std::min(GetConcurrency(policy), size / MIN_PARALLEL_SORT_CHUNK);
+    if (chunk_count <= 1) {
+        std::sort(first, last, compare);
+        return;
+    }
+    std::vector<size_t> bounds(chunk_count + 1);
+    for (size_t i = 0; i <= chunk_count; ++i) {
+        bounds[i] = size * i / chunk_count;
+    }
+    policy.pool.ParallelFor(chunk_count, [&](size_t chunk) {
+        std::sort(first + bounds[chunk], first + bounds[chunk + 1], compare);
+    });
+    for (size_t width = 1; width < chunk_count; width *= 2) {
+        policy.pool.ParallelFor((chunk_count + 2 * width - 1) / (2 * width), [&](size_t pair) {
+            const size_t begin = pair * 2 * width;
+            const size_t middle = std::min(begin + width, chunk_count);
+            const size_t end = std::min(begin + 2 * width, chunk_count);
+            if (middle < end) {
+                std::inplace_merge(first + bounds[begin], first + bounds[middle], first + bounds[end], compare);
+            }
+        });
+    }
+}
+
+template <typename Iterator>
+void Sort(const PoolPolicy& policy, Iterator first, Iterator last) {
+    Sort(policy, first, last, std::less<typename std::iterator_traits<Iterator>::value_type>());
+}
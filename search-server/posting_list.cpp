@@ -0,0 +1,589 @@
+#include "posting_list.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+uint8_t GetBitWidth(uint32_t max_value) {
+    uint8_t width = 0;
+    while (width < 32 && (max_value >> width) != 0) {
+        ++width;
+    }
+    return width;
+}
+
+bool FitsBitWidth(uint64_t value, uint8_t width) {
+    return (value >> width) == 0;
+}
+
+// Widths never exceed 32 bits.
+uint64_t GetLowMask(uint8_t width) {
+    return (uint64_t{ 1 } << width) - 1;
+}
+
+// The 64 bits starting at bit. The word after the one holding bit is read even when no
+// field spans it, which the zero word after the last block makes safe; shifting by one
+// and then by 63 - shift keeps the shift amounts below 64 without a branch.
+uint64_t ReadWord(const uint64_t* words, uint64_t bit) {
+    const uint64_t index = bit >> 6;
+    const unsigned shift = bit & 63;
+    return (words[index] >> shift) | ((words[index + 1] << 1) << (63 - shift));
+}
+
+// A block whose fields all have width 0 owns no words, so nothing may be read for it.
+uint32_t ReadBits(const uint64_t* words, uint64_t bit, uint8_t width) {
+    if (width == 0) {
+        return 0;
+    }
+    return static_cast<uint32_t>(ReadWord(words, bit) & GetLowMask(width));
+}
+
+// A block is unpacked in groups of GROUP_SIZE postings, which take a whole number of
+// bytes at any width. Within a group every field sits at a fixed byte and shift, so a
+// posting costs one unaligned load, a shift by a constant and the split into its two
+// fields. A field must fit in the 64 bits loaded after its byte, which holds up to
+// MAX_GROUP_BITS bits per posting; wider blocks, the tail of the last block and
+// big-endian hosts, where bytes of a word are not in bit order, use ReadWord instead.
+constexpr size_t GROUP_SIZE = 8;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+constexpr unsigned MAX_GROUP_BITS = 0;
+#else
+constexpr unsigned MAX_GROUP_BITS = 57;
+#endif
+
+struct BlockFields {
+    int first_document_id;
+    uint32_t min_term_count;
+    uint8_t document_id_bits;
+    uint64_t document_id_mask;
+    uint64_t term_count_mask;
+};
+
+uint64_t LoadUnaligned(const unsigned char* bytes) {
+    uint64_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+template <unsigned BITS, size_t... INDEXES>
+void UnpackGroup(const unsigned char* bytes, const BlockFields& fields, int* document_ids, uint32_t* term_counts, std::index_sequence<INDEXES...>) {
+    const auto unpack = [&](size_t index, size_t byte, unsigned shift) {
+        const uint64_t posting = LoadUnaligned(bytes + byte) >> shift;
+        document_ids[index] = fields.first_document_id + static_cast<int>(posting & fields.document_id_mask);
+        term_counts[index] = fields.min_term_count + static_cast<uint32_t>((posting >> fields.document_id_bits) & fields.term_count_mask);
+    };
+    (unpack(INDEXES, INDEXES * BITS / 8, INDEXES * BITS % 8), ...);
+}
+
+template <unsigned BITS>
+void UnpackGroups(const unsigned char* bytes, size_t group_count, BlockFields fields, int* document_ids, uint32_t* term_counts) {
+    for (size_t group = 0; group < group_count; ++group) {
+        UnpackGroup<BITS>(bytes + group * BITS, fields, document_ids + group * GROUP_SIZE, term_counts + group * GROUP_SIZE, std::make_index_sequence<GROUP_SIZE>());
+    }
+}
+
+using UnpackGroupsFunction = void (*)(const unsigned char*, size_t, BlockFields, int*, uint32_t*);
+
+template <size_t... WIDTHS>
+constexpr std::array<UnpackGroupsFunction, sizeof...(WIDTHS)> MakeUnpackGroupsTable(std::index_sequence<WIDTHS...>) {
+    return { &UnpackGroups<WIDTHS>... };
+}
+
+// Indexed by bits per posting.
+constexpr auto UNPACK_GROUPS = MakeUnpackGroupsTable(std::make_index_sequence<MAX_GROUP_BITS + 1>());
+
+void WriteBits(uint64_t* words, uint64_t bit, uint8_t width, uint32_t value) {
+    if (width == 0) {
+        return;
+    }
+    const uint64_t index = bit >> 6;
+    const unsigned shift = bit & 63;
+    words[index] |= uint64_t{ value } << shift;
+    if (shift + width > 64) {
+        words[index + 1] |= uint64_t{ value } >> (64 - shift);
+    }
+}
+
+}
+
+PostingList::Cursor::Cursor(const PostingList& postings, size_t first, size_t last)
+    : postings_(&postings)
+    , end_(last) {
+    Seek(first, first < last ? postings.FindBlockAt(first) : 0);
+}
+
+void PostingList::Cursor::SkipTo(int document_id) {
+    if (IsAtEnd() || document_id_ >= document_id) {
+        return;
+    }
+    size_t block = 0;
+    if (!IsInBlock()) {
+        const size_t next_block = block_ + 1;
+        if (next_block < postings_->blocks_.size() && postings_->blocks_[next_block].first_document_id <= document_id) {
+            const size_t position = postings_->Search(next_block, postings_->GetBlockBegin(next_block), end_, document_id, true, block);
+            Seek(position, block);
+            return;
+        }
+        // The target is in the current block, which is now read more than once.
+        LoadBlock();
+    }
+    else if (document_ids_[block_size_ - 1] < document_id) {
+        const size_t position = postings_->Search(block_ + 1, block_begin_ + block_size_, end_, document_id, true, block);
+        Seek(position, block);
+        return;
+    }
+    const int* first = document_ids_ + (position_ - block_begin_);
+    const int* last = document_ids_ + block_size_;
+    const size_t offset = std::lower_bound(first, last, document_id) - document_ids_;
+    if (offset == block_size_) {
+        // Every id of the block is smaller; the target is the first posting of the next one.
+        Seek(block_begin_ + block_size_, block_ + 1);
+        return;
+    }
+    position_ = block_begin_ + offset;
+    document_id_ = document_ids_[offset];
+}
+
+void PostingList::Cursor::EnterBlock() {
+    if (!IsAtEnd()) {
+        if (position_ >= postings_->GetBlockEnd(block_)) {
+            ++block_;
+        }
+        LoadBlock();
+        document_id_ = document_ids_[position_ - block_begin_];
+    }
+}
+
+void PostingList::Cursor::Seek(size_t position, size_t block) {
+    position_ = position;
+    block_ = block;
+    block_size_ = 0;
+    if (!IsAtEnd()) {
+        const Block& current = postings_->blocks_[block_];
+        document_id_ = postings_->GetDocumentId(current, position_ - current.first_position);
+    }
+}
+
+void PostingList::Cursor::LoadBlock() {
+    const Block& block = postings_->blocks_[block_];
+    const uint64_t* words = postings_->words_.data();
+    const uint64_t bits_per_posting = block.document_id_bits + block.term_count_bits;
+    const BlockFields fields{ block.first_document_id, block.min_term_count, block.document_id_bits, GetLowMask(block.document_id_bits), GetLowMask(block.term_count_bits) };
+
+    block_begin_ = block.first_position;
+    block_size_ = postings_->GetBlockSize(block_);
+    if (bits_per_posting == 0) {
+        std::fill_n(document_ids_, block_size_, block.first_document_id);
+        std::fill_n(term_counts_, block_size_, block.min_term_count);
+        return;
+    }
+    // A group's loads reach at most seven bytes past its end, which the words after the
+    // block or the zero word that ends words_ cover.
+    const size_t group_count = bits_per_posting <= MAX_GROUP_BITS ? block_size_ / GROUP_SIZE : 0;
+    if (group_count > 0) {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(words + block.first_word);
+        UNPACK_GROUPS[bits_per_posting](bytes, group_count, fields, document_ids_, term_counts_);
+    }
+    // Both fields of a posting fit in one 64-bit read, and the widths are fixed for the
+    // block, so the loop has no branch but its own.
+    uint64_t bit = uint64_t{ block.first_word } * 64 + group_count * GROUP_SIZE * bits_per_posting;
+    for (size_t i = group_count * GROUP_SIZE; i < block_size_; ++i, bit += bits_per_posting) {
+        const uint64_t posting = ReadWord(words, bit);
+        document_ids_[i] = fields.first_document_id + static_cast<int>(posting & fields.document_id_mask);
+        term_counts_[i] = fields.min_term_count + static_cast<uint32_t>((posting >> fields.document_id_bits) & fields.term_count_mask);
+    }
+}
+
+size_t PostingList::size() const noexcept {
+    return size_;
+}
+
+bool PostingList::empty() const noexcept {
+    return size_ == 0;
+}
+
+int PostingList::GetDocumentId(size_t position) const {
+    const Block& block = blocks_[FindBlockAt(position)];
+    return GetDocumentId(block, position - block.first_position);
+}
+
+uint32_t PostingList::GetTermCount(size_t position) const {
+    return Get(position).term_count;
+}
+
+Posting PostingList::Get(size_t position) const {
+    const Block& block = blocks_[FindBlockAt(position)];
+    return Get(block, position - block.first_position);
+}
+
+int PostingList::GetLastDocumentId() const {
+    const Block& block = blocks_.back();
+    return GetDocumentId(block, size_ - 1 - block.first_position);
+}
+
+size_t PostingList::LowerBound(size_t first, size_t last, int document_id) const {
+    if (first >= last) {
+        return last;
+    }
+    size_t block = 0;
+    return Search(FindBlockAt(first), first, last, document_id, true, block);
+}
+
+size_t PostingList::UpperBound(size_t first, size_t last, int document_id) const {
+    if (first >= last) {
+        return last;
+    }
+    size_t block = 0;
+    return Search(FindBlockAt(first), first, last, document_id, false, block);
+}
+
+bool PostingList::Contains(int document_id) const {
+    const size_t position = LowerBound(0, size_, document_id);
+    return position < size_ && GetDocumentId(position) == document_id;
+}
+
+double PostingList::GetMaxTermFreq() const noexcept {
+    return max_term_freq_;
+}
+
+void PostingList::RaiseMaxTermFreq(double term_freq) noexcept {
+    max_term_freq_ = std::max(max_term_freq_, term_freq);
+}
+
+double PostingList::GetLogDocumentFreq() const noexcept {
+    return log_document_freq_;
+}
+
+std::vector<Posting> PostingList::Decode() const {
+    std::vector<Posting> postings;
+    postings.reserve(size_);
+    for (size_t block = 0; block < blocks_.size(); ++block) {
+        DecodeBlock(block, postings);
+    }
+    return postings;
+}
+
+void PostingList::Assign(const std::vector<Posting>& postings) {
+    Assign(postings.data(), postings.data() + postings.size());
+}
+
+void PostingList::Assign(const Posting* first, const Posting* last) {
+    blocks_.clear();
+    words_.clear();
+    free_words_ = 0;
+    EncodeBlocks(first, last, 0);
+    if (!blocks_.empty()) {
+        words_.push_back(0);
+    }
+    size_ = last - first;
+    log_document_freq_ = empty() ? 0.0 : std::log(size_);
+}
+
+void PostingList::Append(const Posting* first, const Posting* last) {
+    if (first == last) {
+        return;
+    }
+    while (first != last && TryAppendInPlace(*first)) {
+        ++first;
+    }
+    if (first != last) {
+        std::vector<Posting> postings;
+        if (!blocks_.empty() && GetBlockSize(blocks_.size() - 1) < BLOCK_SIZE) {
+            DecodeBlock(blocks_.size() - 1, postings);
+            const Block& block = blocks_.back();
+            const size_t word_count = GetWordCount(block, postings.size());
+            if (block.first_word + word_count + 1 == words_.size()) {
+                words_.resize(block.first_word + 1);
+            }
+            else {
+                free_words_ += word_count;
+            }
+            blocks_.pop_back();
+            size_ -= postings.size();
+        }
+        if (!words_.empty()) {
+            words_.pop_back();
+        }
+        postings.insert(postings.end(), first, last);
+        EncodeBlocks(postings.data(), postings.data() + postings.size(), size_);
+        words_.push_back(0);
+        size_ += postings.size();
+        ReclaimWords();
+    }
+    log_document_freq_ = std::log(size_);
+}
+
+void PostingList::Insert(const Posting& posting) {
+    if (empty() || GetLastDocumentId() < posting.document_id) {
+        Append(&posting, &posting + 1);
+        return;
+    }
+    const size_t block = FindBlock(0, blocks_.size(), posting.document_id);
+    std::vector<Posting> postings;
+    postings.reserve(BLOCK_SIZE + 1);
+    DecodeBlock(block, postings);
+    const auto position = std::lower_bound(postings.begin(), postings.end(), posting.document_id, [](const Posting& entry, int document_id) {
+        return entry.document_id < document_id;
+    });
+    if (position != postings.end() && position->document_id == posting.document_id) {
+        position->term_count += posting.term_count;
+    }
+    else {
+        postings.insert(position, posting);
+    }
+    ReplaceBlock(block, postings);
+    ReclaimWords();
+    log_document_freq_ = std::log(size_);
+}
+
+bool PostingList::Erase(int document_id) {
+    if (empty()) {
+        return false;
+    }
+    const size_t block = FindBlock(0, blocks_.size(), document_id);
+    std::vector<Posting> postings;
+    postings.reserve(BLOCK_SIZE);
+    DecodeBlock(block, postings);
+    const auto position = std::lower_bound(postings.begin(), postings.end(), document_id, [](const Posting& entry, int document_id) {
+        return entry.document_id < document_id;
+    });
+    if (position == postings.end() || position->document_id != document_id) {
+        return false;
+    }
+    postings.erase(position);
+    ReplaceBlock(block, postings);
+    ReclaimWords();
+    log_document_freq_ = empty() ? 0.0 : std::log(size_);
+    return true;
+}
+
+void PostingList::ShrinkToFit() {
+    if (free_words_ > 0) {
+        Assign(Decode());
+    }
+    blocks_.shrink_to_fit();
+    words_.shrink_to_fit();
+}
+
+size_t PostingList::GetMemoryUsage() const noexcept {
+    return blocks_.capacity() * sizeof(Block) + words_.capacity() * sizeof(uint64_t);
+}
+
+size_t PostingList::GetBlockBegin(size_t block) const noexcept {
+    return blocks_[block].first_position;
+}
+
+size_t PostingList::GetBlockEnd(size_t block) const noexcept {
+    return block + 1 < blocks_.size() ? blocks_[block + 1].first_position : size_;
+}
+
+size_t PostingList::GetBlockSize(size_t block) const noexcept {
+    return GetBlockEnd(block) - GetBlockBegin(block);
+}
+
+size_t PostingList::FindBlockAt(size_t position) const {
+    const auto it = std::upper_bound(blocks_.begin() + 1, blocks_.end(), position, [](size_t target, const Block& block) {
+        return target < block.first_position;
+    });
+    return it - blocks_.begin() - 1;
+}
+
+size_t PostingList::FindBlock(size_t first_block, size_t last_block, int document_id) const {
+    const auto it = std::upper_bound(blocks_.begin() + first_block + 1, blocks_.begin() + last_block, document_id, [](int id, const Block& block) {
+        return id < block.first_document_id;
+    });
+    return it - blocks_.begin() - 1;
+}
+
+size_t PostingList::Search(size_t first_block, size_t first, size_t last, int document_id, bool inclusive, size_t& block) const {
+    block = first_block;
+    if (first >= last) {
+        return last;
+    }
+    // Every later block starts above document_id, so the answer lies in this block or is
+    // the first position after it.
+    block = FindBlock(first_block, blocks_.size(), document_id);
+    const size_t block_begin = GetBlockBegin(block);
+    const size_t block_end = GetBlockEnd(block);
+    if (block_begin >= last) {
+        return last;
+    }
+    size_t low = std::max(first, block_begin) - block_begin;
+    size_t high = std::min(last, block_end) - block_begin;
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        const int middle_document_id = GetDocumentId(blocks_[block], middle);
+        if (middle_document_id < document_id || (!inclusive && middle_document_id == document_id)) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    if (block_begin + low == block_end) {
+        ++block;
+    }
+    return block_begin + low;
+}
+
+int PostingList::GetDocumentId(const Block& block, size_t index) const {
+    const uint64_t bit = uint64_t{ block.first_word } * 64 + index * (block.document_id_bits + block.term_count_bits);
+    return block.first_document_id + static_cast<int>(ReadBits(words_.data(), bit, block.document_id_bits));
+}
+
+Posting PostingList::Get(const Block& block, size_t index) const {
+    const uint64_t bits_per_posting = block.document_id_bits + block.term_count_bits;
+    if (bits_per_posting == 0) {
+        return { block.first_document_id, block.min_term_count };
+    }
+    const uint64_t fields = ReadWord(words_.data(), uint64_t{ block.first_word } * 64 + index * bits_per_posting);
+    return {
+        block.first_document_id + static_cast<int>(fields & GetLowMask(block.document_id_bits)),
+        block.min_term_count + static_cast<uint32_t>((fields >> block.document_id_bits) & GetLowMask(block.term_count_bits))
+    };
+}
+
+void PostingList::DecodeBlock(size_t block, std::vector<Posting>& postings) const {
+    const size_t block_size = GetBlockSize(block);
+    for (size_t index = 0; index < block_size; ++index) {
+        postings.push_back(Get(blocks_[block], index));
+    }
+}
+
+bool PostingList::TryAppendInPlace(const Posting& posting) {
+    if (blocks_.empty()) {
+        return false;
+    }
+    const Block& block = blocks_.back();
+    const size_t block_size = size_ - block.first_position;
+    // Only a block whose words end at the zero word can grow in place.
+    if (block_size == BLOCK_SIZE || block.first_word + GetWordCount(block, block_size) + 1 != words_.size()) {
+        return false;
+    }
+    if (posting.term_count < block.min_term_count) {
+        return false;
+    }
+    const uint32_t document_id_offset = static_cast<uint32_t>(posting.document_id - block.first_document_id);
+    const uint32_t term_count_offset = posting.term_count - block.min_term_count;
+    if (!FitsBitWidth(document_id_offset, block.document_id_bits) || !FitsBitWidth(term_count_offset, block.term_count_bits)) {
+        return false;
+    }
+
+    const uint64_t bits_per_posting = block.document_id_bits + block.term_count_bits;
+    const uint64_t bit = uint64_t{ block.first_word } * 64 + block_size * bits_per_posting;
+    // The zero word after the block is overwritten as it grows and one is added behind it.
+    words_.resize(std::max<size_t>(words_.size(), (bit + bits_per_posting + 63) / 64 + 1));
+    WriteBits(words_.data(), bit, block.document_id_bits, document_id_offset);
+    WriteBits(words_.data(), bit + block.document_id_bits, block.term_count_bits, term_count_offset);
+    ++size_;
+    return true;
+}
+
+void PostingList::EncodeBlocks(const Posting* first, const Posting* last, size_t first_position) {
+    while (first != last) {
+        const Posting* block_last = first + std::min<size_t>(BLOCK_SIZE, last - first);
+        Block block = MakeBlock(first, block_last, first_position);
+        block.first_word = static_cast<uint32_t>(words_.size());
+        words_.resize(words_.size() + GetWordCount(block, block_last - first));
+        WriteBlock(block, first, block_last);
+        blocks_.push_back(block);
+        first_position += block_last - first;
+        first = block_last;
+    }
+}
+
+PostingList::Block PostingList::MakeBlock(const Posting* first, const Posting* last, size_t first_position) {
+    Block block{ first->document_id, first->term_count, static_cast<uint32_t>(first_position), 0, 0, 0 };
+    uint32_t max_term_count = first->term_count;
+    for (const Posting* posting = first; posting != last; ++posting) {
+        block.min_term_count = std::min(block.min_term_count, posting->term_count);
+        max_term_count = std::max(max_term_count, posting->term_count);
+    }
+    block.document_id_bits = GetBitWidth(static_cast<uint32_t>((last - 1)->document_id - first->document_id));
+    block.term_count_bits = GetBitWidth(max_term_count - block.min_term_count);
+    return block;
+}
+
+size_t PostingList::GetWordCount(const Block& block, size_t size) noexcept {
+    return (size * (block.document_id_bits + block.term_count_bits) + 63) / 64;
+}
+
+void PostingList::WriteBlock(const Block& block, const Posting* first, const Posting* last) {
+    const uint64_t bits_per_posting = block.document_id_bits + block.term_count_bits;
+    std::fill_n(words_.begin() + block.first_word, GetWordCount(block, last - first), 0);
+    uint64_t bit = uint64_t{ block.first_word } * 64;
+    for (const Posting* posting = first; posting != last; ++posting, bit += bits_per_posting) {
+        WriteBits(words_.data(), bit, block.document_id_bits, static_cast<uint32_t>(posting->document_id - block.first_document_id));
+        WriteBits(words_.data(), bit + block.document_id_bits, block.term_count_bits, posting->term_count - block.min_term_count);
+    }
+}
+
+void PostingList::ReplaceBlock(size_t block, const std::vector<Posting>& postings) {
+    const Block old_block = blocks_[block];
+    const size_t old_size = GetBlockSize(block);
+    const size_t old_word_count = GetWordCount(old_block, old_size);
+    // Words at the end of words_ are given back by shrinking it rather than left free.
+    const bool is_last_in_words = old_block.first_word + old_word_count + 1 == words_.size();
+
+    // A block that outgrew BLOCK_SIZE is split in two halves.
+    std::vector<Block> new_blocks;
+    std::vector<size_t> new_sizes;
+    const size_t split = postings.size() > BLOCK_SIZE ? postings.size() / 2 : postings.size();
+    for (const auto& [begin, end] : { std::pair<size_t, size_t>{ 0, split }, { split, postings.size() } }) {
+        if (begin < end) {
+            new_blocks.push_back(MakeBlock(postings.data() + begin, postings.data() + end, old_block.first_position + begin));
+            new_sizes.push_back(end - begin);
+        }
+    }
+
+    if (new_blocks.size() == 1 && GetWordCount(new_blocks.front(), postings.size()) <= old_word_count) {
+        const size_t word_count = GetWordCount(new_blocks.front(), postings.size());
+        new_blocks.front().first_word = old_block.first_word;
+        WriteBlock(new_blocks.front(), postings.data(), postings.data() + postings.size());
+        if (is_last_in_words) {
+            words_.resize(old_block.first_word + word_count);
+            words_.push_back(0);
+        }
+        else {
+            free_words_ += old_word_count - word_count;
+        }
+    }
+    else {
+        if (is_last_in_words) {
+            words_.resize(old_block.first_word);
+        }
+        else {
+            free_words_ += old_word_count;
+            words_.pop_back();
+        }
+        const Posting* first = postings.data();
+        for (size_t i = 0; i < new_blocks.size(); ++i) {
+            new_blocks[i].first_word = static_cast<uint32_t>(words_.size());
+            words_.resize(words_.size() + GetWordCount(new_blocks[i], new_sizes[i]));
+            WriteBlock(new_blocks[i], first, first + new_sizes[i]);
+            first += new_sizes[i];
+        }
+        words_.push_back(0);
+    }
+
+    blocks_.erase(blocks_.begin() + block);
+    blocks_.insert(blocks_.begin() + block, new_blocks.begin(), new_blocks.end());
+    for (size_t later = block + new_blocks.size(); later < blocks_.size(); ++later) {
+        blocks_[later].first_position = static_cast<uint32_t>(blocks_[later].first_position + postings.size() - old_size);
+    }
+    size_ = size_ + postings.size() - old_size;
+    if (blocks_.empty()) {
+        words_.clear();
+        free_words_ = 0;
+    }
+}
+
+void PostingList::ReclaimWords() {
+    if (free_words_ * 2 > words_.size()) {
+        Assign(Decode());
+    }
+}
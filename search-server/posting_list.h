@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Occurrence of a term in a document. Term frequency is term_count / document_length,
+// where the length counts the document's words without stop words and is kept with the
+// document rather than in every posting.
+struct Posting {
+    int document_id;
+    uint32_t term_count;
+};
+
+inline double ComputeTermFreq(uint32_t term_count, uint32_t document_length) {
+    return static_cast<double>(term_count) / document_length;
+}
+
+// Postings of a term sorted by document id, compressed in blocks of up to BLOCK_SIZE.
+// Within a block every field is stored as its offset from the block minimum and bit-packed
+// with the smallest width that fits (frame of reference). Any position decodes after a
+// bisection over the blocks, so lists are still searched by bisection, and a block of a
+// dense term takes a few bits per posting instead of the 12 bytes of an int id and a
+// double frequency. Inserting or erasing a posting re-encodes only its block: in place
+// when it still fits, otherwise at the end of the words, and a full block is split in
+// two. Words left behind are reclaimed by re-encoding the whole list once they outnumber
+// the words in use. A zero word ends the words, so a field is always read with two loads
+// and no branch.
+class PostingList {
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+
+    // Forward iterator over a range of positions. Stepping unpacks the document ids and
+    // term counts of a whole block in one pass; a posting reached by a skip is read in
+    // place until the cursor steps or skips within its block again, since a sparse
+    // skipping cursor rarely reads more than one posting of a block. The current document
+    // id is kept decoded, so comparing cursors costs no more than indexing an array.
+    class Cursor {
+    public:
+        Cursor() = default;
+        Cursor(const PostingList& postings, size_t first, size_t last);
+
+        bool IsAtEnd() const noexcept;
+        // Only meaningful while the cursor is not at its end.
+        int GetDocumentId() const noexcept;
+        uint32_t GetTermCount() const;
+        void Next();
+        // Moves forward to the first posting whose document id is not less than document_id.
+        void SkipTo(int document_id);
+
+    private:
+        bool IsInBlock() const noexcept;
+        // Reads the current posting after a step left the decoded block.
+        void EnterBlock();
+        // Moves to position, which lies in block, and reads its document id in place.
+        void Seek(size_t position, size_t block);
+        void LoadBlock();
+
+        const PostingList* postings_ = nullptr;
+        size_t position_ = 0;
+        size_t end_ = 0;
+        // Block holding position_ while the cursor is not at its end.
+        size_t block_ = 0;
+        int document_id_ = 0;
+        // Position of the first posting of the decoded block and the number decoded;
+        // none are decoded right after a skip.
+        size_t block_begin_ = 0;
+        size_t block_size_ = 0;
+        int document_ids_[BLOCK_SIZE];
+        uint32_t term_counts_[BLOCK_SIZE];
+    };
+
+    size_t size() const noexcept;
+    bool empty() const noexcept;
+
+    int GetDocumentId(size_t position) const;
+    uint32_t GetTermCount(size_t position) const;
+    Posting Get(size_t position) const;
+    int GetLastDocumentId() const;
+
+    // First position in [first, last) whose document id is not less than document_id,
+    // or last. Whole blocks are skipped by their first id.
+    size_t LowerBound(size_t first, size_t last, int document_id) const;
+    // First position in [first, last) whose document id is greater than document_id.
+    size_t UpperBound(size_t first, size_t last, int document_id) const;
+    bool Contains(int document_id) const;
+
+    // Upper bound of the term frequencies in the list. The list does not know document
+    // lengths, so whoever adds postings raises it; removals leave it in place, where it
+    // stays a valid, if looser, bound.
+    double GetMaxTermFreq() const noexcept;
+    void RaiseMaxTermFreq(double term_freq) noexcept;
+    // log(size()), refreshed whenever the list grows or shrinks, so IDF is one subtraction.
+    double GetLogDocumentFreq() const noexcept;
+
+    std::vector<Posting> Decode() const;
+    // Replaces the postings; they must be sorted by document id.
+    void Assign(const std::vector<Posting>& postings);
+    void Assign(const Posting* first, const Posting* last);
+    // Adds postings whose ids are greater than every id in the list. A posting that fits
+    // the bit widths of the last block is written in place; otherwise only the last block
+    // is re-encoded.
+    void Append(const Posting* first, const Posting* last);
+    // Adds a posting anywhere in the list, or adds its term count to the posting with the
+    // same document id.
+    void Insert(const Posting& posting);
+    // Removes the posting of document_id; returns false if there is none.
+    bool Erase(int document_id);
+
+    void ShrinkToFit();
+    // Heap bytes held by the list.
+    size_t GetMemoryUsage() const noexcept;
+
+private:
+    struct Block {
+        int first_document_id;
+        uint32_t min_term_count;
+        uint32_t first_position;
+        // Blocks start at word boundaries, so any of them can be re-encoded in place.
+        uint32_t first_word;
+        uint8_t document_id_bits;
+        uint8_t term_count_bits;
+    };
+
+    size_t GetBlockBegin(size_t block) const noexcept;
+    size_t GetBlockEnd(size_t block) const noexcept;
+    size_t GetBlockSize(size_t block) const noexcept;
+    // Block holding position, which must be less than size().
+    size_t FindBlockAt(size_t position) const;
+    // Last block in [first_block, last_block) whose first id is not greater than
+    // document_id, or first_block if there is none.
+    size_t FindBlock(size_t first_block, size_t last_block, int document_id) const;
+    // First position in [first, last) whose document id is greater than document_id, or
+    // not less than it if inclusive; block receives the block holding that position.
+    // first must lie in first_block.
+    size_t Search(size_t first_block, size_t first, size_t last, int document_id, bool inclusive, size_t& block) const;
+    int GetDocumentId(const Block& block, size_t index) const;
+    Posting Get(const Block& block, size_t index) const;
+    void DecodeBlock(size_t block, std::vector<Posting>& postings) const;
+    bool TryAppendInPlace(const Posting& posting);
+    // Appends blocks of up to BLOCK_SIZE at the end of words_, the first one starting at
+    // first_position; callers put the zero word back after them.
+    void EncodeBlocks(const Posting* first, const Posting* last, size_t first_position);
+    // Block of postings with the smallest widths that fit them, not yet placed in words_.
+    static Block MakeBlock(const Posting* first, const Posting* last, size_t first_position);
+    static size_t GetWordCount(const Block& block, size_t size) noexcept;
+    void WriteBlock(const Block& block, const Posting* first, const Posting* last);
+    // Replaces the postings of block, which may leave it empty or hold one more posting
+    // than BLOCK_SIZE, and shifts the positions of the blocks after it.
+    void ReplaceBlock(size_t block, const std::vector<Posting>& postings);
+    void ReclaimWords();
+
+    // The offsets of a posting are packed next to each other: document id, then term count.
+    std::vector<Block> blocks_;
+    std::vector<uint64_t> words_;
+    // Words of words_ that no block owns.
+    size_t free_words_ = 0;
+    size_t size_ = 0;
+    double max_term_freq_ = 0.0;
+    double log_document_freq_ = 0.0;
+};
+
+inline bool PostingList::Cursor::IsAtEnd() const noexcept {
+    return position_ >= end_;
+}
+
+inline bool PostingList::Cursor::IsInBlock() const noexcept {
+    return position_ - block_begin_ < block_size_;
+}
+
+inline int PostingList::Cursor::GetDocumentId() const noexcept {
+    return document_id_;
+}
+
+inline uint32_t PostingList::Cursor::GetTermCount() const {
+    if (!IsInBlock()) {
+        const Block& block = postings_->blocks_[block_];
+        return postings_->Get(block, position_ - block.first_position).term_count;
+    }
+    return term_counts_[position_ - block_begin_];
+}
+
+inline void PostingList::Cursor::Next() {
+    ++position_;
+    if (IsInBlock()) {
+        document_id_ = document_ids_[position_ - block_begin_];
+    }
+    else {
+        EnterBlock();
+    }
+}
@@ -1,11 +1,7 @@
 #include "process_queries.h"
 
 std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,  const std::vector<std::string>& queries) {
-	std::vector<std::vector<Document>> documents_lists(queries.size());
-	std::transform(std::execution::par, queries.begin(), queries.end(), documents_lists.begin(), [&search_server](const std::string& query) { 
-		return search_server.FindTopDocuments(query); 
-	});
-	return documents_lists;
+	return search_server.FindTopDocumentsBatch(std::execution::par, queries);
 }
 
 std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries) {
@@ -14,4 +10,22 @@ std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, co
 		documents.insert(documents.end(), document.begin(), document.end());
 	}
 	return documents;
-}
\ No newline at end of file
+}
+
+std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries, ThreadPool& pool) {
+	return search_server.FindTopDocumentsBatch(pool.GetPolicy(), queries);
+}
+
+std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries, ThreadPool& pool) {
+	std::vector<Document> documents;
+	for (const auto& document : ProcessQueries(search_server, queries, pool)) {
+		documents.insert(documents.end(), document.begin(), document.end());
+	}
+	return documents;
+}
+
+std::vector<std::vector<Document>> ProcessQueries(const ConcurrentSearchServer& search_server, const std::vector<std::string>& queries) {
+	return search_server.Read([&queries](const SearchServer& server) {
+		return ProcessQueries(server, queries);
+	});
+}
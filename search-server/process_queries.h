@@ -1,7 +1,9 @@
 #pragma once
 
+#include "concurrent_search_server.h"
 #include "document.h"
 #include "search_server.h"
+#include "thread_pool.h"
 
 #include <vector>
 #include <execution>
@@ -9,3 +11,10 @@
 std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries);
 
 std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries);
+
+// Same as above, but run on the workers of pool instead of the std::execution::par backend.
+std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server, const std::vector<std::string>& queries, ThreadPool& pool);
+
+std::vector<Document> ProcessQueriesJoined(const SearchServer& search_server, const std::vector<std::string>& queries, ThreadPool& pool);
+
+std::vector<std::vector<Document>> ProcessQueries(const ConcurrentSearchServer& search_server, const std::vector<std::string>& queries);
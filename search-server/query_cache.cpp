@@ -0,0 +1,113 @@
+#include "query_cache.h"
+
+#include <algorithm>
+#include <functional>
+
+QueryCache::QueryCache(size_t capacity, size_t shard_count)
+    : shard_capacity_(std::max<size_t>(1, capacity / std::max<size_t>(1, shard_count))) {
+    shards_.resize(std::max<size_t>(1, shard_count));
+    for (auto& shard : shards_) {
+        shard = std::make_unique<Shard>();
+    }
+}
+
+std::vector<Document> QueryCache::FindTopDocuments(const SearchServer& search_server, std::string_view raw_query, DocumentStatus status, size_t max_count) {
+    std::string key = MakeKey(search_server.NormalizeQuery(raw_query), status, max_count);
+    const uint64_t generation = search_server.GetGeneration();
+    Shard& shard = GetShard(key);
+
+    {
+        std::lock_guard guard(shard.mutex);
+        if (const auto it = shard.index.find(key); it != shard.index.end()) {
+            if (it->second->generation == generation) {
+                shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+                ++hit_count_;
+                return it->second->documents;
+            }
+            shard.memory_usage -= GetEntryMemoryUsage(*it->second);
+            shard.entries.erase(it->second);
+            shard.index.erase(it);
+        }
+    }
+
+    ++miss_count_;
+    std::vector<Document> documents = search_server.FindTopDocuments(raw_query, status, max_count);
+
+    std::lock_guard guard(shard.mutex);
+    if (shard.index.count(key) > 0) {
+        return documents;
+    }
+    shard.entries.push_front({ std::move(key), generation, documents });
+    shard.index.emplace(shard.entries.front().key, shard.entries.begin());
+    shard.memory_usage += GetEntryMemoryUsage(shard.entries.front());
+    if (shard.entries.size() > shard_capacity_) {
+        const Entry& last = shard.entries.back();
+        shard.memory_usage -= GetEntryMemoryUsage(last);
+        shard.index.erase(last.key);
+        shard.entries.pop_back();
+    }
+    return documents;
+}
+
+void QueryCache::Clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard guard(shard->mutex);
+        shard->index.clear();
+        shard->entries.clear();
+        shard->memory_usage = 0;
+    }
+}
+
+uint64_t QueryCache::GetHitCount() const noexcept {
+    return hit_count_;
+}
+
+uint64_t QueryCache::GetMissCount() const noexcept {
+    return miss_count_;
+}
+
+double QueryCache::GetHitRate() const noexcept {
+    const uint64_t hit_count = hit_count_;
+    const uint64_t request_count = hit_count + miss_count_;
+    return request_count == 0 ? 0.0 : static_cast<double>(hit_count) / request_count;
+}
+
+size_t QueryCache::GetSize() const {
+    size_t size = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard guard(shard->mutex);
+        size += shard->entries.size();
+    }
+    return size;
+}
+
+size_t QueryCache::GetMemoryUsage() const {
+    size_t bytes = sizeof(*this) + shards_.capacity() * (sizeof(std::unique_ptr<Shard>) + sizeof(Shard));
+    for (const auto& shard : shards_) {
+        std::lock_guard guard(shard->mutex);
+        bytes += shard->memory_usage + shard->index.bucket_count() * sizeof(void*);
+    }
+    return bytes;
+}
+
+std::string QueryCache::MakeKey(std::string_view normalized_query, DocumentStatus status, size_t max_count) {
+    std::string key(normalized_query);
+    key.push_back('\0');
+    key.append(std::to_string(static_cast<int>(status)));
+    key.push_back('\0');
+    key.append(std::to_string(max_count));
+    return key;
+}
+
+size_t QueryCache::GetEntryMemoryUsage(const Entry& entry) {
+    // List node, index node and the owned buffers.
+    size_t bytes = sizeof(Entry) + 2 * sizeof(void*);
+    bytes += sizeof(std::string_view) + sizeof(std::list<Entry>::iterator) + 2 * sizeof(void*);
+    bytes += entry.key.capacity() > 15 ? entry.key.capacity() + 1 : 0;
+    bytes += entry.documents.capacity() * sizeof(Document);
+    return bytes;
+}
+
+QueryCache::Shard& QueryCache::GetShard(std::string_view key) {
+    return *shards_[std::hash<std::string_view>()(key) % shards_.size()];
+}
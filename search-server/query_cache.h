@@ -0,0 +1,56 @@
+#pragma once
+
+#include "document.h"
+#include "search_server.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Sharded LRU cache of FindTopDocuments results for one SearchServer. Entries are keyed
+// by the normalized query, status and result count, and are tagged with the server
+// generation they were computed at; an entry from an older generation is a miss.
+class QueryCache {
+public:
+    explicit QueryCache(size_t capacity, size_t shard_count = 16);
+
+    std::vector<Document> FindTopDocuments(const SearchServer& search_server, std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL, size_t max_count = MAX_RESULT_DOCUMENT_COUNT);
+
+    void Clear();
+
+    uint64_t GetHitCount() const noexcept;
+    uint64_t GetMissCount() const noexcept;
+    double GetHitRate() const noexcept;
+    size_t GetSize() const;
+    size_t GetMemoryUsage() const;
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t generation;
+        std::vector<Document> documents;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> entries;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+        size_t memory_usage = 0;
+    };
+
+    static std::string MakeKey(std::string_view normalized_query, DocumentStatus status, size_t max_count);
+    static size_t GetEntryMemoryUsage(const Entry& entry);
+    Shard& GetShard(std::string_view key);
+
+    size_t shard_capacity_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<uint64_t> hit_count_ = 0;
+    std::atomic<uint64_t> miss_count_ = 0;
+};
@@ -0,0 +1,32 @@
+#include "query_deadline.h"
+
+CancellationToken::CancellationToken()
+    : is_cancelled_(std::make_shared<std::atomic<bool>>(false)) {
+}
+
+void CancellationToken::Cancel() noexcept {
+    is_cancelled_->store(true, std::memory_order_relaxed);
+}
+
+bool CancellationToken::IsCancelled() const noexcept {
+    return is_cancelled_->load(std::memory_order_relaxed);
+}
+
+QueryDeadline::QueryDeadline(Clock::duration budget)
+    : has_expiry_(true), expiry_(Clock::now() + budget) {
+}
+
+QueryDeadline::QueryDeadline(CancellationToken token)
+    : is_cancelled_(std::move(token.is_cancelled_)) {
+}
+
+QueryDeadline::QueryDeadline(Clock::duration budget, CancellationToken token)
+    : has_expiry_(true), expiry_(Clock::now() + budget), is_cancelled_(std::move(token.is_cancelled_)) {
+}
+
+bool QueryDeadline::IsExpired() const noexcept {
+    if (is_cancelled_ && is_cancelled_->load(std::memory_order_relaxed)) {
+        return true;
+    }
+    return has_expiry_ && Clock::now() >= expiry_;
+}
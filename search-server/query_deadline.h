@@ -0,0 +1,51 @@
+#pragma once
+
+#include "document.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+// Shared flag that lets one thread cancel queries running on others. Copies refer to the
+// same flag.
+class CancellationToken {
+public:
+    CancellationToken();
+
+    void Cancel() noexcept;
+    bool IsCancelled() const noexcept;
+
+private:
+    friend class QueryDeadline;
+
+    std::shared_ptr<std::atomic<bool>> is_cancelled_;
+};
+
+// Point after which a query stops scoring: a latency budget, a cancellation token, both
+// or neither. The budget is counted from construction, so time spent queued counts too.
+class QueryDeadline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Never expires.
+    QueryDeadline() = default;
+    explicit QueryDeadline(Clock::duration budget);
+    explicit QueryDeadline(CancellationToken token);
+    QueryDeadline(Clock::duration budget, CancellationToken token);
+
+    bool IsExpired() const noexcept;
+
+private:
+    bool has_expiry_ = false;
+    Clock::time_point expiry_;
+    std::shared_ptr<const std::atomic<bool>> is_cancelled_;
+};
+
+// Top documents of a query that may have been stopped by its deadline. Documents are
+// ranked by their exact relevance, but an incomplete result has only seen part of the
+// index and may miss better documents.
+struct QueryResult {
+    std::vector<Document> documents;
+    bool is_complete = true;
+};
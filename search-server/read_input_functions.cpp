@@ -1,5 +1,12 @@
 #include "read_input_functions.h"
 
+#include <charconv>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+
+using namespace std::string_literals;
+
 std::string ReadLine() {
     std::string s;
     std::getline(std::cin, s);
@@ -12,3 +19,103 @@ int ReadLineWithNumber() {
     ReadLine();
     return result;
 }
+
+namespace {
+
+std::string_view TakeField(std::string_view& line) {
+    const size_t tab_pos = line.find('\t');
+    if (tab_pos == line.npos) {
+        throw std::invalid_argument("corpus line has too few fields"s);
+    }
+    const std::string_view field = line.substr(0, tab_pos);
+    line.remove_prefix(tab_pos + 1);
+    return field;
+}
+
+int ParseNumber(std::string_view text) {
+    int value = 0;
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || end != text.data() + text.size()) {
+        throw std::invalid_argument("invalid number in corpus line: "s + std::string(text));
+    }
+    return value;
+}
+
+DocumentStatus ParseStatus(std::string_view text) {
+    if (text == "ACTUAL") {
+        return DocumentStatus::ACTUAL;
+    }
+    if (text == "IRRELEVANT") {
+        return DocumentStatus::IRRELEVANT;
+    }
+    if (text == "BANNED") {
+        return DocumentStatus::BANNED;
+    }
+    if (text == "REMOVED") {
+        return DocumentStatus::REMOVED;
+    }
+    throw std::invalid_argument("invalid document status in corpus line: "s + std::string(text));
+}
+
+NewDocument ParseCorpusLine(std::string_view line) {
+    NewDocument document;
+    document.id = ParseNumber(TakeField(line));
+    document.status = ParseStatus(TakeField(line));
+    for (std::string_view rating : SplitIntoWordsView(TakeField(line))) {
+        if (!rating.empty()) {
+            document.ratings.push_back(ParseNumber(rating));
+        }
+    }
+    document.text = line;
+    return document;
+}
+
+}
+
+CorpusLoadResult LoadDocuments(SearchServer& search_server, const std::string& path, size_t batch_size) {
+    auto file = std::make_shared<const MappedFile>(path);
+    search_server.RetainTextSource(file);
+    std::string_view data = file->GetData();
+
+    CorpusLoadResult result;
+    std::vector<NewDocument> batch;
+    std::vector<size_t> batch_lines;
+    const auto flush = [&]() {
+        const std::vector<std::exception_ptr> errors = search_server.AddDocuments(std::execution::par, batch);
+        for (size_t i = 0; i < errors.size(); ++i) {
+            if (errors[i]) {
+                result.errors.emplace_back(batch_lines[i], errors[i]);
+            }
+            else {
+                ++result.added_count;
+            }
+        }
+        batch.clear();
+        batch_lines.clear();
+    };
+
+    for (size_t line_number = 1; !data.empty(); ++line_number) {
+        const size_t end_pos = data.find('\n');
+        std::string_view line = data.substr(0, end_pos);
+        data.remove_prefix(end_pos != data.npos ? end_pos + 1 : data.size());
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.empty()) {
+            continue;
+        }
+
+        try {
+            batch.push_back(ParseCorpusLine(line));
+            batch_lines.push_back(line_number);
+        }
+        catch (...) {
+            result.errors.emplace_back(line_number, std::current_exception());
+        }
+        if (batch.size() >= batch_size) {
+            flush();
+        }
+    }
+    flush();
+    return result;
+}
@@ -1,7 +1,24 @@
 #pragma once
 
+#include "search_server.h"
+
+#include <cstddef>
+#include <exception>
 #include <iostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 std::string ReadLine();
 int ReadLineWithNumber();
+
+struct CorpusLoadResult {
+    size_t added_count = 0;
+    // Line number and reason for every line that was not added.
+    std::vector<std::pair<size_t, std::exception_ptr>> errors;
+};
+
+// Loads a corpus with one document per line: "id<TAB>status<TAB>ratings<TAB>text", where
+// status is ACTUAL, IRRELEVANT, BANNED or REMOVED and ratings are separated by spaces.
+// The file is memory-mapped and indexed in batches; document texts are not copied.
+CorpusLoadResult LoadDocuments(SearchServer& search_server, const std::string& path, size_t batch_size = 4096);
@@ -0,0 +1,9 @@
+#include "remove_duplicates.h"
+
+void RemoveDuplicates(SearchServer& search_server) {
+    const std::vector<int> duplicates = search_server.FindDuplicates(std::execution::par);
+    for (const int document_id : duplicates) {
+        std::cout << "Found duplicate document id "s << document_id << std::endl;
+    }
+    search_server.RemoveDocuments(std::execution::par, duplicates);
+}
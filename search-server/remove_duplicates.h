@@ -0,0 +1,7 @@
+#pragma once
+
+#include "search_server.h"
+
+// Removes every document whose set of words repeats that of a document with a lower id,
+// printing the id of each removed document.
+void RemoveDuplicates(SearchServer& search_server);
@@ -1,11 +1,19 @@
 #include "request_queue.h"
 
+RequestQueue::RequestQueue(const SearchServer& search_server, QueryCache* cache, size_t window_size)
+    : search_server_(search_server), cache_(cache), requests_(std::max<size_t>(1, window_size)) {
+}
 
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentStatus status) {
-    return AddFindRequest(raw_query,
-                          [status](int document_id, DocumentStatus document_status, int rating) {
-                              return document_status == status;
-                          });
+    if (cache_ == nullptr) {
+        return AddFindRequest(raw_query,
+                              [status](int document_id, DocumentStatus document_status, int rating) {
+                                  return document_status == status;
+                              });
+    }
+    std::vector<Document> docs = cache_->FindTopDocuments(search_server_, raw_query, status);
+    AddRequest(docs.size() > 0);
+    return docs;
 }
 
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query) {
@@ -13,6 +21,19 @@ std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query)
 }
 
 int RequestQueue::GetNoResultRequests() const {
-    return std::count(requests_.begin(), requests_.end(), false);
+    // Concurrent updates may briefly apply a decrement before the matching increment.
+    return static_cast<int>(std::max<int64_t>(0, no_result_count_.load(std::memory_order_relaxed)));
+}
+
+size_t RequestQueue::GetWindowSize() const noexcept {
+    return requests_.size();
 }
 
+void RequestQueue::AddRequest(bool has_result) {
+    const uint64_t request = request_count_.fetch_add(1, std::memory_order_relaxed);
+    const uint8_t is_empty = has_result ? 0 : 1;
+    const uint8_t replaced = requests_[request % requests_.size()].exchange(is_empty, std::memory_order_relaxed);
+    if (is_empty != replaced) {
+        no_result_count_.fetch_add(static_cast<int64_t>(is_empty) - replaced, std::memory_order_relaxed);
+    }
+}
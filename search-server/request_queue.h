@@ -1,17 +1,24 @@
 #pragma once
 
 #include <algorithm>
-#include <deque>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 #include "search_server.h"
 #include "document.h"
+#include "query_cache.h"
 #include "config.h"
 
+// Counts requests without results among the last window_size requests. Requests may be
+// added from many threads at once: every request claims the next slot of a ring buffer
+// and the no-result counter is adjusted by the difference to the value it replaced, so
+// the count is always read in O(1).
 class RequestQueue {
 public:
-    explicit RequestQueue(const SearchServer& search_server) : search_server_(search_server) {}
+    explicit RequestQueue(const SearchServer& search_server, QueryCache* cache = nullptr, size_t window_size = MIN_IN_DAY);
 
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate);
@@ -21,26 +28,22 @@ public:
     std::vector<Document> AddFindRequest(const std::string& raw_query);
 
     int GetNoResultRequests() const;
+    size_t GetWindowSize() const noexcept;
 
 private:
-    std::deque<bool> requests_;
-    const static int min_in_day_ = MIN_IN_DAY;
     const SearchServer& search_server_;
-    int minutes = 0;
+    // Optional; only requests filtered by status are cached.
+    QueryCache* cache_;
+    std::vector<std::atomic<uint8_t>> requests_;
+    alignas(64) std::atomic<uint64_t> request_count_ = 0;
+    alignas(64) std::atomic<int64_t> no_result_count_ = 0;
+
+    void AddRequest(bool has_result);
 };
 
 template <typename DocumentPredicate>
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
     std::vector<Document> docs = search_server_.FindTopDocuments(raw_query, document_predicate);
-
-    minutes++;
-
-    if (minutes > min_in_day_) {
-        requests_.pop_front();
-        minutes--;
-    }
-
-    requests_.push_back(docs.size() > 0);
-
+    AddRequest(docs.size() > 0);
     return docs;
 }
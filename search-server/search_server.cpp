@@ -1,41 +1,85 @@
 #include "search_server.h"
+#include "mapped_file.h"
+#include "mapped_terms.h"
+#include "snapshot.h"
+
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
 
 void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
-    if (document_id < 0) {
-        throw std::invalid_argument("document_id must be >= 0");
-    }
-    if (documents_.count(document_id) > 0) {
-        throw std::invalid_argument("document_id must be unique");
-    }
-    if (document.empty()) {
-        throw std::invalid_argument("document is empty");
+    CheckNewDocument(document_id, document);
+    const WordCounts word_counts = CountWords(document);
+
+    std::vector<InvertedIndex::TermFrequency> term_freqs;
+    term_freqs.reserve(word_counts.counts.size());
+    for (const auto [word, term_count] : word_counts.counts) {
+        const InvertedIndex::TermId term_id = word_to_document_freqs_.AddTerm(word);
+        word_to_document_freqs_.AddPosting(term_id, { document_id, term_count }, word_counts.length);
+        term_freqs.push_back({ term_id, term_count });
     }
+    SortByTermId(term_freqs);
+    documents_.emplace(document_id, DocumentData{ StoreText(document), std::move(term_freqs) });
+    document_attributes_.Set(document_id, { word_counts.length, SearchServer::ComputeAverageRating(ratings), status });
 
-    auto words = SplitIntoWordsNoStop(document);
-    const std::string document_string{ document };
-    documents_.emplace(document_id, DocumentData{ SearchServer::ComputeAverageRating(ratings), status, document_string });
-    words = SplitIntoWordsNoStop(documents_.at(document_id).text_);
-    
-    for (auto word : words) {
-        word_to_document_freqs_[word][document_id] += 1.0 / words.size();
-        document_to_word_freqs_[document_id][word] += 1.0 / words.size();
-    }
-    
     document_ids_.emplace(document_id);
+    log_document_count_ = std::log(GetDocumentCount());
+    ++generation_;
 }
 
-std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(std::execution::seq, raw_query, status);
+std::vector<std::exception_ptr> SearchServer::AddDocuments(const std::vector<NewDocument>& documents) {
+    return AddDocuments(std::execution::seq, documents);
+}
+
+void SearchServer::RetainTextSource(std::shared_ptr<const MappedFile> source) {
+    text_sources_.push_back(std::move(source));
+}
+
+void SearchServer::SetCorpusStatistics(const CorpusStatistics* statistics) noexcept {
+    corpus_statistics_ = statistics;
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status, size_t max_count, QueryEvaluation evaluation) const {
+    return FindTopDocuments(std::execution::seq, raw_query, status, max_count, evaluation);
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) const {
     return FindTopDocuments(std::execution::seq, raw_query, DocumentStatus::ACTUAL);
 }
 
+std::future<QueryResult> SearchServer::FindTopDocumentsAsync(ThreadPool& pool, std::string raw_query, QueryDeadline deadline, DocumentStatus status, size_t max_count, QueryEvaluation evaluation) const {
+    return FindTopDocumentsAsync(pool, std::move(raw_query), std::move(deadline), [status](int document_id, DocumentStatus document_status, int rating) {
+        return document_status == status;
+    }, max_count, evaluation);
+}
+
 int SearchServer::GetDocumentCount() const {
     return static_cast<int>(documents_.size());
 }
 
+uint64_t SearchServer::GetGeneration() const noexcept {
+    return generation_;
+}
+
+std::string SearchServer::NormalizeQuery(std::string_view raw_query) const {
+    Query& query = GetQueryContext().query;
+    ParseQuery(raw_query, query);
+
+    std::string normalized;
+    for (const std::string_view word : query.plus_words) {
+        normalized.append(word).push_back(' ');
+    }
+    for (const std::string_view word : query.minus_words) {
+        normalized.append("-"s).append(word).push_back(' ');
+    }
+    if (!normalized.empty()) {
+        normalized.pop_back();
+    }
+    return normalized;
+}
+
 const std::set<int>::const_iterator SearchServer::begin() const noexcept {
     return document_ids_.begin();
 }
@@ -45,28 +89,30 @@ const std::set<int>::const_iterator SearchServer::end() const noexcept {
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
-    const Query query = ParseQuery(raw_query);
+    if ((document_id < 0) || (documents_.count(document_id) == 0)) {
+        throw std::invalid_argument("document_id out of range"s);
+    }
 
-    std::vector<std::string_view> matched_words;
-    for (const std::string_view word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.clear();
-            return { {}, documents_.at(document_id).status };
-        }
+    Query& query = GetQueryContext().query;
+    {
+        SEARCH_STAGE_TIMER(SearchOperation::MATCH_DOCUMENT, SearchStage::PARSE);
+        ParseQuery(raw_query, query);
     }
-    for (const std::string_view word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.push_back(word);
+
+    std::vector<std::string_view> matched_words;
+    {
+        SEARCH_STAGE_TIMER(SearchOperation::MATCH_DOCUMENT, SearchStage::TRAVERSAL);
+        const auto is_in_document = [this, document_id](const std::string_view word) {
+            const auto* postings = word_to_document_freqs_.Find(word);
+            return postings != nullptr && postings->Contains(document_id);
+        };
+        if (std::none_of(query.minus_words.begin(), query.minus_words.end(), is_in_document)) {
+            std::copy_if(query.plus_words.begin(), query.plus_words.end(), std::back_inserter(matched_words), is_in_document);
         }
     }
 
-    return { matched_words, documents_.at(document_id).status };
+    SEARCH_STAGE_TIMER(SearchOperation::MATCH_DOCUMENT, SearchStage::RESULT);
+    return { std::move(matched_words), document_attributes_.Get(document_id).status };
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::sequenced_policy& policy, std::string_view raw_query, int document_id) const {
@@ -74,49 +120,209 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::parallel_policy& policy, std::string_view raw_query, int document_id) const {
-    if ((document_id < 0) || (documents_.count(document_id) == 0)) {
-            throw std::invalid_argument("document_id out of range"s);
+    return MatchDocumentParallel(policy, raw_query, document_id);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const PoolPolicy& policy, std::string_view raw_query, int document_id) const {
+    return MatchDocumentParallel(policy, raw_query, document_id);
+}
+
+DocumentMatches SearchServer::MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids) const {
+    return MatchDocuments(std::execution::seq, raw_query, document_ids);
+}
+
+WordFrequencies SearchServer::GetWordFrequencies(int document_id) const {
+    const auto it = documents_.find(document_id);
+    if (it == documents_.end()) {
+        throw std::invalid_argument("document_id out of range"s);
+    }
+    return WordFrequencies(word_to_document_freqs_, it->second.GetTermFreqs(), document_attributes_.Get(document_id).length);
+}
+
+void SearchServer::RemoveDocument(int document_id) {
+    RemoveDocument(std::execution::seq, document_id);
+}
+
+void SearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    RemoveDocuments(std::execution::seq, document_ids);
+}
+
+std::vector<int> SearchServer::FindDuplicates() const {
+    return FindDuplicates(std::execution::seq);
+}
+
+void SearchServer::Compact() {
+    // Renumbering keeps the order of ids, and mapped terms keep theirs above every
+    // renumbered one, so forward indexes stay sorted.
+    const std::vector<InvertedIndex::TermId> new_term_ids = word_to_document_freqs_.Compact();
+
+    TextArena texts;
+    for (auto& [document_id, document_data] : documents_) {
+        for (InvertedIndex::TermFrequency& entry : document_data.term_freqs) {
+            if (entry.term_id < InvertedIndex::FIRST_MAPPED_TERM) {
+                entry.term_id = new_term_ids[entry.term_id];
+            }
+        }
+        document_data.term_freqs.shrink_to_fit();
+        if (!IsInTextSource(document_data.text_)) {
+            document_data.text_ = texts.Store(document_data.text_);
         }
+    }
+    texts_ = std::move(texts);
+    document_attributes_.Shrink();
+}
+
+size_t SearchServer::GetTermCount() const noexcept {
+    return word_to_document_freqs_.GetTermCount();
+}
+
+size_t SearchServer::GetPostingCount() const noexcept {
+    return word_to_document_freqs_.GetPostingCount();
+}
 
-    const Query& query = ParseQueryParallel(raw_query);
-    const auto& word_freqs = document_to_word_freqs_.at(document_id);
-    
-    if (std::any_of(query.minus_words.begin(), query.minus_words.end(), [&word_freqs](const std::string_view word) {return word_freqs.count(word) > 0;})) {
-        return { {}, documents_.at(document_id).status };
+size_t SearchServer::GetPostingMemoryUsage() const noexcept {
+    return word_to_document_freqs_.GetPostingMemoryUsage();
+}
+
+size_t SearchServer::GetMemoryUsage() const noexcept {
+    // Red-black tree nodes carry three pointers and a color besides the value.
+    constexpr size_t NODE_OVERHEAD = 4 * sizeof(void*);
+
+    size_t bytes = word_to_document_freqs_.GetMemoryUsage() + texts_.GetMemoryUsage() + document_attributes_.GetMemoryUsage();
+    bytes += documents_.size() * (NODE_OVERHEAD + sizeof(std::pair<const int, DocumentData>));
+    bytes += document_ids_.size() * (NODE_OVERHEAD + sizeof(int));
+    for (const auto& [document_id, document_data] : documents_) {
+        bytes += document_data.term_freqs.capacity() * sizeof(InvertedIndex::TermFrequency);
     }
+    return bytes;
+}
 
-    std::vector<std::string_view> matched_words;
-    matched_words.reserve(query.plus_words.size());
-    std::copy_if(query.plus_words.begin(), query.plus_words.end(), std::back_inserter(matched_words), [&word_freqs](const std::string_view word) {
-        return word_freqs.count(word) > 0;
+void SearchServer::SaveSnapshot(const std::string& path) const {
+    std::ofstream output(path, std::ios::binary);
+    if (!output) {
+        throw std::runtime_error("cannot open snapshot file "s + path);
+    }
+
+    SnapshotWriter writer(output);
+    writer.WriteHeader();
+
+    writer.Write<uint64_t>(stop_words_.size());
+    for (const std::string& word : stop_words_) {
+        writer.WriteString(word);
+    }
+
+    // The dictionary is sorted so that a mapped snapshot finds terms by bisection, and
+    // forward indexes name terms by their place in it.
+    std::vector<std::pair<std::string_view, InvertedIndex::TermId>> terms;
+    terms.reserve(word_to_document_freqs_.GetTermCount());
+    word_to_document_freqs_.ForEachTerm([&terms](InvertedIndex::TermId term_id, std::string_view term, const InvertedIndex::PostingList&) {
+        terms.emplace_back(term, term_id);
     });
+    std::sort(terms.begin(), terms.end());
+    std::unordered_map<InvertedIndex::TermId, InvertedIndex::TermId> saved_term_ids;
+    saved_term_ids.reserve(terms.size());
+    for (size_t i = 0; i < terms.size(); ++i) {
+        saved_term_ids.emplace(terms[i].second, InvertedIndex::FIRST_MAPPED_TERM + static_cast<InvertedIndex::TermId>(i));
+    }
 
-    std::sort(policy, matched_words.begin(), matched_words.end());
-    auto it = std::unique(matched_words.begin(), matched_words.end());
-    matched_words.erase(it, matched_words.end());
+    std::vector<SnapshotDocumentRecord> document_records;
+    document_records.reserve(documents_.size());
+    uint64_t text_size = 0;
+    uint64_t forward_size = 0;
+    for (const auto& [document_id, document_data] : documents_) {
+        const DocumentAttributes& attributes = document_attributes_.Get(document_id);
+        const size_t term_count = document_data.GetTermFreqs().size();
+        document_records.push_back({ document_id, attributes.rating, static_cast<int32_t>(attributes.status), attributes.length,
+            text_size, document_data.text_.size(), forward_size, term_count });
+        text_size += document_data.text_.size();
+        forward_size += term_count;
+    }
+    writer.WriteArray(document_records);
 
-    return { matched_words, documents_.at(document_id).status };
-}
+    writer.BeginArray<char>(text_size);
+    for (const auto& [document_id, document_data] : documents_) {
+        writer.WriteValues(document_data.text_.data(), document_data.text_.size());
+    }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    if (document_to_word_freqs_.count(document_id) == 0) {
-        throw std::invalid_argument("document_id out of range"s);
+    writer.BeginArray<InvertedIndex::TermFrequency>(forward_size);
+    std::vector<InvertedIndex::TermFrequency> term_freqs;
+    for (const auto& [document_id, document_data] : documents_) {
+        const ArrayView<InvertedIndex::TermFrequency> document_term_freqs = document_data.GetTermFreqs();
+        term_freqs.assign(document_term_freqs.begin(), document_term_freqs.end());
+        for (InvertedIndex::TermFrequency& entry : term_freqs) {
+            entry.term_id = saved_term_ids.at(entry.term_id);
+        }
+        SortByTermId(term_freqs);
+        writer.WriteValues(term_freqs.data(), term_freqs.size());
+    }
+
+    std::vector<SnapshotTermRecord> term_records;
+    term_records.reserve(terms.size());
+    uint64_t term_text_size = 0;
+    uint64_t posting_count = 0;
+    for (const auto& [term, term_id] : terms) {
+        const size_t term_posting_count = word_to_document_freqs_.GetPostings(term_id).size();
+        term_records.push_back({ term_text_size, posting_count, static_cast<uint32_t>(term.size()), static_cast<uint32_t>(term_posting_count) });
+        term_text_size += term.size();
+        posting_count += term_posting_count;
+    }
+    writer.WriteArray(term_records);
+
+    writer.BeginArray<char>(term_text_size);
+    for (const auto& [term, term_id] : terms) {
+        writer.WriteValues(term.data(), term.size());
+    }
+
+    writer.BeginArray<Posting>(posting_count);
+    for (const auto& [term, term_id] : terms) {
+        const std::vector<Posting> postings = word_to_document_freqs_.GetPostings(term_id).Decode();
+        writer.WriteValues(postings.data(), postings.size());
+    }
+
+    if (!output.flush()) {
+        throw std::runtime_error("cannot write snapshot file "s + path);
     }
-    return document_to_word_freqs_.at(document_id);
 }
 
-void SearchServer::RemoveDocument(int document_id) {
-    if (document_to_word_freqs_.count(document_id)) {
-        std::map<std::string_view, double> search_element = document_to_word_freqs_[document_id];
+SearchServer SearchServer::LoadSnapshot(const std::string& path) {
+    auto file = std::make_shared<const MappedFile>(path);
+    SnapshotReader reader(file->GetData());
+    reader.ReadHeader();
 
-        for (auto [key_string, value_double] : search_element) {
-            word_to_document_freqs_[key_string].erase(document_id);
+    std::vector<std::string_view> stop_words(reader.Read<uint64_t>());
+    for (std::string_view& word : stop_words) {
+        word = reader.ReadString();
+    }
+    SearchServer search_server(stop_words);
+    search_server.RetainTextSource(file);
+
+    const auto documents = reader.ViewArray<SnapshotDocumentRecord>();
+    const auto texts = reader.ViewArray<char>();
+    const auto forward_index = reader.ViewArray<InvertedIndex::TermFrequency>();
+    const auto terms = reader.ViewArray<SnapshotTermRecord>();
+    const auto term_text = reader.ViewArray<char>();
+    const auto postings = reader.ViewArray<Posting>();
+
+    int previous_document_id = -1;
+    for (const SnapshotDocumentRecord& record : documents) {
+        if (record.id <= previous_document_id || record.status < 0 || record.status > static_cast<int32_t>(DocumentStatus::REMOVED)
+            || record.text_offset > texts.size() || record.text_size > texts.size() - record.text_offset
+            || record.forward_offset > forward_index.size() || record.forward_size > forward_index.size() - record.forward_offset) {
+            throw std::runtime_error("snapshot document is corrupted");
         }
+        previous_document_id = record.id;
 
-        document_to_word_freqs_.erase(document_id);
-        documents_.erase(document_id);
-        document_ids_.erase(document_id);
+        const std::string_view text(texts.data() + record.text_offset, record.text_size);
+        const ArrayView<InvertedIndex::TermFrequency> term_freqs(forward_index.data() + record.forward_offset, record.forward_size);
+        search_server.documents_.emplace_hint(search_server.documents_.end(), record.id, DocumentData{ text, {}, term_freqs });
+        search_server.document_attributes_.Set(record.id, { record.length, record.rating, static_cast<DocumentStatus>(record.status) });
+        search_server.document_ids_.emplace_hint(search_server.document_ids_.end(), record.id);
     }
+
+    search_server.word_to_document_freqs_.MapTerms(std::make_unique<MappedTerms>(std::move(file), terms,
+        std::string_view(term_text.data(), term_text.size()), postings, documents, forward_index));
+    search_server.log_document_count_ = std::log(search_server.GetDocumentCount());
+    return search_server;
 }
 
 bool SearchServer::IsStopWord(std::string_view word) const {
@@ -129,8 +335,11 @@ bool SearchServer::IsValidWord(std::string_view word) {
 
 std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const {
     std::vector<std::string_view> words;
-    for (const auto& word : SplitIntoWordsView(text)) {
-        if (!IsValidWord(word)) {
+    WordTokenizer tokenizer(text);
+    std::string_view word;
+    bool is_valid = true;
+    while (tokenizer.Next(word, is_valid)) {
+        if (!is_valid) {
             throw std::invalid_argument("invalid word"s);
         }
         if (!IsStopWord(word)) {
@@ -140,6 +349,39 @@ std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_vie
     return words;
 }
 
+void SearchServer::CheckNewDocument(int document_id, std::string_view document) const {
+    if (document_id < 0) {
+        throw std::invalid_argument("document_id must be >= 0");
+    }
+    if (documents_.count(document_id) > 0) {
+        throw std::invalid_argument("document_id must be unique");
+    }
+    if (document.empty()) {
+        throw std::invalid_argument("document is empty");
+    }
+}
+
+SearchServer::WordCounts SearchServer::CountWords(std::string_view document) const {
+    const auto words = SplitIntoWordsNoStop(document);
+    WordCounts word_counts;
+    for (auto word : words) {
+        ++word_counts.counts[word];
+    }
+    word_counts.length = static_cast<uint32_t>(words.size());
+    return word_counts;
+}
+
+std::string_view SearchServer::StoreText(std::string_view text) {
+    return IsInTextSource(text) ? text : texts_.Store(text);
+}
+
+bool SearchServer::IsInTextSource(std::string_view text) const {
+    return std::any_of(text_sources_.begin(), text_sources_.end(), [text](const auto& source) {
+        const std::string_view data = source->GetData();
+        return std::less_equal<const char*>()(data.data(), text.data()) && std::less_equal<const char*>()(text.data() + text.size(), data.data() + data.size());
+    });
+}
+
 int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     if (ratings.empty()) {
         return 0;
@@ -151,7 +393,53 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     return rating_sum / static_cast<int>(ratings.size());
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const {
+bool SearchServer::HasTerm(ArrayView<InvertedIndex::TermFrequency> term_freqs, InvertedIndex::TermId term_id) {
+    const auto it = std::lower_bound(term_freqs.begin(), term_freqs.end(), term_id, [](const InvertedIndex::TermFrequency& entry, InvertedIndex::TermId id) {
+        return entry.term_id < id;
+    });
+    return it != term_freqs.end() && it->term_id == term_id;
+}
+
+// Two independent order-sensitive hashes of the sorted term ids; the ids are interned,
+// so equal term sets give equal sequences.
+SearchServer::TermSetFingerprint SearchServer::ComputeTermSetFingerprint(ArrayView<InvertedIndex::TermFrequency> term_freqs) {
+    const auto mix = [](uint64_t value) {
+        value += 0x9e3779b97f4a7c15ULL;
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    };
+
+    TermSetFingerprint fingerprint{ term_freqs.size(), ~uint64_t{ 0 } };
+    for (const InvertedIndex::TermFrequency& entry : term_freqs) {
+        fingerprint.high = mix(fingerprint.high ^ entry.term_id);
+        fingerprint.low = mix(fingerprint.low + (uint64_t{ entry.term_id } << 32 | entry.term_id));
+    }
+    return fingerprint;
+}
+
+bool SearchServer::HaveSameTerms(ArrayView<InvertedIndex::TermFrequency> lhs, ArrayView<InvertedIndex::TermFrequency> rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const InvertedIndex::TermFrequency& lhs_entry, const InvertedIndex::TermFrequency& rhs_entry) {
+        return lhs_entry.term_id == rhs_entry.term_id;
+    });
+}
+
+void SearchServer::SortByTermId(std::vector<InvertedIndex::TermFrequency>& term_freqs) {
+    std::sort(term_freqs.begin(), term_freqs.end(), [](const InvertedIndex::TermFrequency& lhs, const InvertedIndex::TermFrequency& rhs) {
+        return lhs.term_id < rhs.term_id;
+    });
+}
+
+void SearchServer::CheckTermFreqs(const DocumentData& document_data) const {
+    const ArrayView<InvertedIndex::TermFrequency> term_freqs = document_data.mapped_term_freqs;
+    for (size_t i = 0; i < term_freqs.size(); ++i) {
+        if (!word_to_document_freqs_.IsMappedTermId(term_freqs[i].term_id) || (i > 0 && term_freqs[i].term_id <= term_freqs[i - 1].term_id)) {
+            throw std::runtime_error("snapshot forward index is corrupted");
+        }
+    }
+}
+
+SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text, bool is_valid) const {
     if (text.empty()) {
         throw std::invalid_argument("Query word is empty"s);
     }
@@ -166,7 +454,7 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
     if (text.empty()) {
         throw std::invalid_argument("Query word i`s empty"s);
     }
-    if (!IsValidWord(text)) {
+    if (!is_valid) {
         throw std::invalid_argument("Query word includes special symbols"s);
     }
     if (text[0] == '-') {
@@ -176,20 +464,8 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
     return {text, is_minus, IsStopWord(text)};
 }
 
-SearchServer::Query SearchServer::ParseQuery(std::string_view text) const {
-    Query query;
-
-    for (auto word : SplitIntoWordsView(text)) {
-        const QueryWord query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                query.minus_words.push_back(query_word.data);
-            }
-            else {
-                query.plus_words.push_back(query_word.data);
-            }
-        }
-    }
+void SearchServer::ParseQuery(std::string_view text, Query& query) const {
+    SplitQueryWords(text, query);
 
     sort(query.minus_words.begin(), query.minus_words.end());
     sort(query.plus_words.begin(), query.plus_words.end());
@@ -199,15 +475,17 @@ SearchServer::Query SearchServer::ParseQuery(std::string_view text) const {
 
     query.minus_words.resize(last_minus - query.minus_words.begin());
     query.plus_words.resize(last_plus - query.plus_words.begin());
-
-    return query;
 }
 
-SearchServer::Query SearchServer::ParseQueryParallel(std::string_view text) const {
-    Query query;
+void SearchServer::SplitQueryWords(std::string_view text, Query& query) const {
+    query.plus_words.clear();
+    query.minus_words.clear();
 
-    for (auto word : SplitIntoWordsView(text)) {
-        const QueryWord query_word(ParseQueryWord(word));
+    WordTokenizer tokenizer(text);
+    std::string_view word;
+    bool is_valid = true;
+    while (tokenizer.Next(word, is_valid)) {
+        const QueryWord query_word = ParseQueryWord(word, is_valid);
         if (!query_word.is_stop) {
             if (query_word.is_minus) {
                 query.minus_words.push_back(query_word.data);
@@ -217,9 +495,140 @@ SearchServer::Query SearchServer::ParseQueryParallel(std::string_view text) cons
             }
         }
     }
-    return query;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word ) const {
-    return std::log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at( word ).size());
+SearchServer::QueryContext& SearchServer::GetQueryContext() {
+    thread_local QueryContext context;
+    return context;
+}
+
+// Evaluates the queries document-at-a-time over the union of their terms: every posting
+// list is read once for the whole group and each document's status is looked up once.
+// Terms are kept in lexicographic order, which is the order of every query's plus words,
+// so each query sums its relevance in the same order as FindTopDocuments does.
+void SearchServer::FindTopDocumentsInGroup(const std::vector<Query>& queries, const size_t* query_indexes, size_t query_count, std::vector<std::vector<Document>>& results) const {
+    struct TermUse {
+        bool is_minus;
+        std::string_view word;
+        uint32_t query;
+    };
+    std::vector<TermUse> uses;
+    for (uint32_t query = 0; query < query_count; ++query) {
+        for (auto word : queries[query_indexes[query]].plus_words) {
+            uses.push_back({ false, word, query });
+        }
+        for (auto word : queries[query_indexes[query]].minus_words) {
+            uses.push_back({ true, word, query });
+        }
+    }
+    std::sort(uses.begin(), uses.end(), [](const TermUse& lhs, const TermUse& rhs) {
+        return std::tie(lhs.is_minus, lhs.word, lhs.query) < std::tie(rhs.is_minus, rhs.word, rhs.query);
+    });
+
+    struct GroupTerm {
+        InvertedIndex::PostingList::Cursor postings;
+        double inverse_document_freq;
+        bool is_minus;
+        std::vector<uint32_t> queries;
+    };
+    std::vector<GroupTerm> terms;
+    bool is_indexed = false;
+    for (size_t i = 0; i < uses.size(); ++i) {
+        if (i > 0 && uses[i].is_minus == uses[i - 1].is_minus && uses[i].word == uses[i - 1].word) {
+            if (is_indexed) {
+                terms.back().queries.push_back(uses[i].query);
+            }
+            continue;
+        }
+        const auto* postings = word_to_document_freqs_.Find(uses[i].word);
+        is_indexed = postings != nullptr && !postings->empty();
+        if (!is_indexed) {
+            continue;
+        }
+        terms.push_back({ InvertedIndex::PostingList::Cursor(*postings, 0, postings->size()), uses[i].is_minus ? 0.0 : ComputeWordInverseDocumentFreq(uses[i].word, *postings), uses[i].is_minus, { uses[i].query } });
+    }
+
+    using HeapEntry = std::pair<int, size_t>;
+    std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap;
+    for (size_t term = 0; term < terms.size(); ++term) {
+        heap.push({ terms[term].postings.GetDocumentId(), term });
+    }
+
+    std::vector<TopDocuments> top_documents(query_count, TopDocuments(MAX_RESULT_DOCUMENT_COUNT));
+    std::vector<double> relevances(query_count, 0.0);
+    // Relevance of every term for the current document, read before its cursor moves on.
+    std::vector<double> relevances_by_term(terms.size(), 0.0);
+    std::vector<char> is_touched(query_count, 0);
+    std::vector<char> is_excluded(query_count, 0);
+    std::vector<uint32_t> touched;
+    std::vector<size_t> hits;
+    while (!heap.empty()) {
+        const int document_id = heap.top().first;
+        const DocumentAttributes& attributes = document_attributes_.Get(document_id);
+        hits.clear();
+        while (!heap.empty() && heap.top().first == document_id) {
+            const size_t term = heap.top().second;
+            heap.pop();
+            hits.push_back(term);
+            InvertedIndex::PostingList::Cursor& postings = terms[term].postings;
+            relevances_by_term[term] = terms[term].is_minus ? 0.0 : ComputeTermFreq(postings.GetTermCount(), attributes.length) * terms[term].inverse_document_freq;
+            postings.Next();
+            if (!postings.IsAtEnd()) {
+                heap.push({ postings.GetDocumentId(), term });
+            }
+        }
+        std::sort(hits.begin(), hits.end());
+        if (terms[hits.front()].is_minus) {
+            continue;
+        }
+
+        if (attributes.status != DocumentStatus::ACTUAL) {
+            continue;
+        }
+
+        for (const size_t term : hits) {
+            const GroupTerm& group_term = terms[term];
+            if (group_term.is_minus) {
+                for (const uint32_t query : group_term.queries) {
+                    is_excluded[query] = 1;
+                }
+                continue;
+            }
+            const double relevance = relevances_by_term[term];
+            for (const uint32_t query : group_term.queries) {
+                if (!is_touched[query]) {
+                    is_touched[query] = 1;
+                    relevances[query] = 0.0;
+                    touched.push_back(query);
+                }
+                relevances[query] += relevance;
+            }
+        }
+
+        for (const uint32_t query : touched) {
+            if (!is_excluded[query]) {
+                top_documents[query].Push({ document_id, relevances[query], attributes.rating });
+            }
+            is_touched[query] = 0;
+        }
+        touched.clear();
+        for (const size_t term : hits) {
+            if (terms[term].is_minus) {
+                for (const uint32_t query : terms[term].queries) {
+                    is_excluded[query] = 0;
+                }
+            }
+        }
+    }
+
+    for (size_t query = 0; query < query_count; ++query) {
+        results[query_indexes[query]] = top_documents[query].Build();
+    }
+}
+
+double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word, const InvertedIndex::PostingList& postings) const {
+    if (corpus_statistics_ != nullptr) {
+        return corpus_statistics_->ComputeInverseDocumentFreq(word);
+    }
+    return log_document_count_ - postings.GetLogDocumentFreq();
 }
\ No newline at end of file
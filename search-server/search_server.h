@@ -1,23 +1,45 @@
 #pragma once
 
+#include "array_view.h"
+#include "corpus_statistics.h"
 #include "document.h"
+#include "document_attributes.h"
+#include "document_matches.h"
+#include "inverted_index.h"
+#include "latency_histogram.h"
+#include "mapped_file.h"
+#include "parallel_algorithms.h"
+#include "query_deadline.h"
 #include "string_processing.h"
 #include "log_duration.h"
-#include "concurrent_map.h"
-#include "log_duration.h"
+#include "text_arena.h"
+#include "top_documents.h"
+#include "word_frequencies.h"
 #include "config.h"
 
 #include <iostream>
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <algorithm>
 #include <stdexcept>
 #include <cmath>
+#include <cstdint>
+#include <exception>
 #include <execution>
+#include <future>
+#include <numeric>
+#include <thread>
+#include <utility>
 
 using namespace std::string_literals;
 
+enum class QueryEvaluation {
+    EXHAUSTIVE,
+    MAX_SCORE,
+};
+
 class SearchServer {
 public:
     template <typename StringContainer>
@@ -29,47 +51,137 @@ public:
 
     void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
+    template <typename ExecutionPolicy>
+    std::vector<std::exception_ptr> AddDocuments(ExecutionPolicy&& policy, const std::vector<NewDocument>& documents);
+    std::vector<std::exception_ptr> AddDocuments(const std::vector<NewDocument>& documents);
+
+    // Texts of documents added later that lie inside source are referenced in place
+    // instead of being copied; the server keeps the mapping alive.
+    void RetainTextSource(std::shared_ptr<const MappedFile> source);
+
+    // Makes the server score as a shard of a larger corpus: IDF is taken from statistics,
+    // which must cover every document of the server and outlive it. nullptr restores
+    // the server's own document frequencies.
+    void SetCorpusStatistics(const CorpusStatistics* statistics) noexcept;
+
     template <typename DocumentPredicate, typename ExecutionPolicy>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count = MAX_RESULT_DOCUMENT_COUNT, QueryEvaluation evaluation = QueryEvaluation::EXHAUSTIVE) const;
 
     template <typename DocumentPredicate>
-    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count = MAX_RESULT_DOCUMENT_COUNT, QueryEvaluation evaluation = QueryEvaluation::EXHAUSTIVE) const;
 
     template <typename ExecutionPolicy>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const;
-    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status, size_t max_count = MAX_RESULT_DOCUMENT_COUNT, QueryEvaluation evaluation = QueryEvaluation::EXHAUSTIVE) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status, size_t max_count = MAX_RESULT_DOCUMENT_COUNT, QueryEvaluation evaluation = QueryEvaluation::EXHAUSTIVE) const;
     
     template <typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query) const;
     std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
 
+    // Like FindTopDocuments, but scoring stops once deadline expires and the best documents
+    // scored by then are returned.
+    template <typename ExecutionPolicy, typename DocumentPredicate>
+    QueryResult FindTopDocumentsWithin(ExecutionPolicy&& policy, std::string_view raw_query, const QueryDeadline& deadline, DocumentPredicate document_predicate, size_t max_count = MAX_RESULT_DOCUMENT_COUNT, QueryEvaluation evaluation = QueryEvaluation::EXHAUSTIVE) const;
+    template <typename ExecutionPolicy>
+    QueryResult FindTopDocumentsWithin(ExecutionPolicy&& policy, std::string_view raw_query, const QueryDeadline& deadline, DocumentStatus status = DocumentStatus::ACTUAL, size_t max_count = MAX_RESULT_DOCUMENT_COUNT, QueryEvaluation evaluation = QueryEvaluation::EXHAUSTIVE) const;
+
+    // Runs FindTopDocumentsWithin on the workers of pool and returns at once. The server
+    // must not be modified or destroyed until the result is ready.
+    template <typename DocumentPredicate>
+    std::future<QueryResult> FindTopDocumentsAsync(ThreadPool& pool, std::string raw_query, QueryDeadline deadline, DocumentPredicate document_predicate, size_t max_count = MAX_RESULT_DOCUMENT_COUNT, QueryEvaluation evaluation = QueryEvaluation::EXHAUSTIVE) const;
+    std::future<QueryResult> FindTopDocumentsAsync(ThreadPool& pool, std::string raw_query, QueryDeadline deadline = QueryDeadline(), DocumentStatus status = DocumentStatus::ACTUAL, size_t max_count = MAX_RESULT_DOCUMENT_COUNT, QueryEvaluation evaluation = QueryEvaluation::EXHAUSTIVE) const;
+
+    // Answers every query like FindTopDocuments(query). Queries are evaluated in groups
+    // that share one pass over the posting lists of their terms.
+    template <typename ExecutionPolicy>
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(ExecutionPolicy&& policy, const std::vector<std::string>& raw_queries) const;
+
     int GetDocumentCount() const;
 
+    // Changes whenever a document is added or removed, so results computed at an older
+    // generation may be stale.
+    uint64_t GetGeneration() const noexcept;
+
+    // Canonical form of a query: sorted unique plus words, then minus words, stop words
+    // dropped. Queries with the same form have the same results.
+    std::string NormalizeQuery(std::string_view raw_query) const;
+
     const std::set<int>::const_iterator begin() const noexcept;
     const std::set<int>::const_iterator end() const noexcept;
 
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::sequenced_policy& policy, std::string_view raw_query, int document_id) const;
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::parallel_policy& policy, std::string_view raw_query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const PoolPolicy& policy, std::string_view raw_query, int document_id) const;
+
+    // Matches the query against every listed document like MatchDocument; the query is
+    // parsed once and the documents are checked independently.
+    template <typename ExecutionPolicy>
+    DocumentMatches MatchDocuments(ExecutionPolicy&& policy, std::string_view raw_query, const std::vector<int>& document_ids) const;
+    DocumentMatches MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids) const;
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    WordFrequencies GetWordFrequencies(int document_id) const;
 
     template <typename ExecutionPolicy>
     void RemoveDocument(ExecutionPolicy&& policy, int document_id);
     void RemoveDocument(int document_id);
 
+    // Removes all listed documents with one pass over each affected posting list.
+    // Ids that are not in the server are ignored.
+    template <typename ExecutionPolicy>
+    void RemoveDocuments(ExecutionPolicy&& policy, const std::vector<int>& document_ids);
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    // Ids of documents whose set of words equals that of a document with a lower id,
+    // in ascending order.
+    template <typename ExecutionPolicy>
+    std::vector<int> FindDuplicates(ExecutionPolicy&& policy) const;
+    std::vector<int> FindDuplicates() const;
+
+    // Releases capacity freed by removed documents; terms themselves are dropped as soon
+    // as their last document is removed.
+    void Compact();
+    size_t GetTermCount() const noexcept;
+    size_t GetPostingCount() const noexcept;
+    // Heap bytes of the compressed posting lists, without per-term headers.
+    size_t GetPostingMemoryUsage() const noexcept;
+    // Approximate heap footprint of the inverted and forward indexes and stored texts.
+    size_t GetMemoryUsage() const noexcept;
+
+    void SaveSnapshot(const std::string& path) const;
+    // Serves a snapshot in place. The file is memory-mapped, and document texts, forward
+    // indexes, the dictionary and posting lists are all read from the mapping: loading
+    // only reads the document records, and a term's posting list is checked and decoded
+    // the first time a query or a change reaches it, so a corrupted list throws from that
+    // call. The server can be changed as usual; a term that changes is copied out of the
+    // mapping first.
+    static SearchServer LoadSnapshot(const std::string& path);
+
 private:
     struct DocumentData {
-        int rating;
-        DocumentStatus status;
-        std::string text_;
+        std::string_view text_;
+        // Forward index, sorted by term id.
+        std::vector<InvertedIndex::TermFrequency> term_freqs;
+        // Forward index of a document read from a mapped snapshot, used instead of
+        // term_freqs; the ids are those of mapped terms.
+        ArrayView<InvertedIndex::TermFrequency> mapped_term_freqs;
+
+        ArrayView<InvertedIndex::TermFrequency> GetTermFreqs() const noexcept {
+            return mapped_term_freqs.empty() ? ArrayView<InvertedIndex::TermFrequency>(term_freqs) : mapped_term_freqs;
+        }
     };
 
     const std::set<std::string, std::less<>> stop_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
+    InvertedIndex word_to_document_freqs_;
     std::map<int, DocumentData> documents_;
+    // Read for every scored document, so it is kept out of documents_.
+    DocumentAttributeTable document_attributes_;
     std::set<int> document_ids_;
+    double log_document_count_ = 0.0;
+    const CorpusStatistics* corpus_statistics_ = nullptr;
+    uint64_t generation_ = 0;
+    TextArena texts_;
+    std::vector<std::shared_ptr<const MappedFile>> text_sources_;
 
     bool IsStopWord(std::string_view word) const;
 
@@ -77,34 +189,99 @@ private:
 
     std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
 
+    void CheckNewDocument(int document_id, std::string_view document) const;
+
+    struct WordCounts {
+        std::map<std::string_view, uint32_t> counts;
+        uint32_t length = 0;
+    };
+
+    WordCounts CountWords(std::string_view document) const;
+
+    std::string_view StoreText(std::string_view text);
+    bool IsInTextSource(std::string_view text) const;
+
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
+    template <typename ExecutionPolicy>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocumentParallel(const ExecutionPolicy& policy, std::string_view raw_query, int document_id) const;
+
+    static bool HasTerm(ArrayView<InvertedIndex::TermFrequency> term_freqs, InvertedIndex::TermId term_id);
+    static void SortByTermId(std::vector<InvertedIndex::TermFrequency>& term_freqs);
+    // Throws if a forward index read from a snapshot is out of order or names terms the
+    // snapshot does not have; checked before the document's postings are removed.
+    void CheckTermFreqs(const DocumentData& document_data) const;
+
+    struct TermSetFingerprint {
+        uint64_t high;
+        uint64_t low;
+    };
+
+    static TermSetFingerprint ComputeTermSetFingerprint(ArrayView<InvertedIndex::TermFrequency> term_freqs);
+    static bool HaveSameTerms(ArrayView<InvertedIndex::TermFrequency> lhs, ArrayView<InvertedIndex::TermFrequency> rhs);
+
     struct QueryWord {
         std::string_view data;
         bool is_minus;
         bool is_stop;
     };
 
-    QueryWord ParseQueryWord(std::string_view text) const;
+    QueryWord ParseQueryWord(std::string_view text, bool is_valid) const;
 
     struct Query {
         std::vector<std::string_view> plus_words;
         std::vector<std::string_view> minus_words;
     };
 
-    Query ParseQuery(std::string_view text) const;
-    Query ParseQueryParallel(std::string_view text) const;
+    // Plus and minus words sorted and without repeats.
+    void ParseQuery(std::string_view text, Query& query) const;
+    // Plus and minus words in query order, repeats kept.
+    void SplitQueryWords(std::string_view text, Query& query) const;
+
+    struct TermCursor {
+        InvertedIndex::PostingList::Cursor postings;
+        double inverse_document_freq;
+        double max_relevance;
+    };
+
+    // Buffers reused by every query on the calling thread, so a warmed-up sequential
+    // query allocates nothing but its result.
+    struct QueryContext {
+        Query query;
+        std::vector<TermCursor> cursors;
+        std::vector<InvertedIndex::PostingList::Cursor> minus_postings;
+        std::vector<size_t> order;
+        std::vector<double> prefix_bounds;
+        std::vector<double> relevances;
+        TopDocuments top_documents{ 0 };
+        // Whether the last FindAllDocuments scored every document before its deadline.
+        bool is_complete = true;
+    };
+
+    static QueryContext& GetQueryContext();
 
     template<typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+    const TopDocuments& FindAllDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation) const;
 
     template<typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
-    
+    const TopDocuments& FindAllDocuments(const std::execution::sequenced_policy& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation, const QueryDeadline& deadline) const;
+
+    template<typename DocumentPredicate>
+    const TopDocuments& FindAllDocuments(const std::execution::parallel_policy& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation, const QueryDeadline& deadline) const;
+
+    template<typename DocumentPredicate>
+    const TopDocuments& FindAllDocuments(const PoolPolicy& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation, const QueryDeadline& deadline) const;
+
+    template<typename DocumentPredicate, typename ExecutionPolicy>
+    const TopDocuments& FindAllDocumentsParallel(const ExecutionPolicy& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation, const QueryDeadline& deadline) const;
+
+    // Returns false if deadline expired before every document of the range was scored.
     template<typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy& policy, std::string_view raw_query, DocumentPredicate document_predicate) const;
+    bool FindAllDocumentsInRange(const Query& query, DocumentPredicate document_predicate, QueryEvaluation evaluation, int first_document_id, int last_document_id, const QueryDeadline& deadline, TopDocuments& top_documents, CandidateSampler& sampler) const;
+
+    void FindTopDocumentsInGroup(const std::vector<Query>& queries, const size_t* query_indexes, size_t query_count, std::vector<std::vector<Document>>& results) const;
 
-    double ComputeWordInverseDocumentFreq(std::string_view word ) const;
+    double ComputeWordInverseDocumentFreq(std::string_view word, const InvertedIndex::PostingList& postings) const;
 };
 
 template <typename StringContainer>
@@ -115,35 +292,51 @@ SearchServer::SearchServer(const StringContainer& stop_words) : stop_words_(Make
 }
 
 template <typename DocumentPredicate, typename ExecutionPolicy>
-std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
-    auto matched_documents = FindAllDocuments(policy, raw_query, document_predicate);
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation) const {
+    const TopDocuments& top_documents = FindAllDocuments(policy, raw_query, document_predicate, max_count, evaluation, QueryDeadline());
+    SEARCH_STAGE_TIMER(SearchOperation::FIND_TOP_DOCUMENTS, SearchStage::RESULT);
+    return top_documents.Build();
+}
+
+template <typename ExecutionPolicy, typename DocumentPredicate>
+QueryResult SearchServer::FindTopDocumentsWithin(ExecutionPolicy&& policy, std::string_view raw_query, const QueryDeadline& deadline, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation) const {
+    const TopDocuments& top_documents = FindAllDocuments(policy, raw_query, document_predicate, max_count, evaluation, deadline);
+    SEARCH_STAGE_TIMER(SearchOperation::FIND_TOP_DOCUMENTS, SearchStage::RESULT);
+    return { top_documents.Build(), GetQueryContext().is_complete };
+}
 
-    std::sort(policy, matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-        if (std::abs(lhs.relevance - rhs.relevance) < EPS) {
-            return lhs.rating > rhs.rating;
+template <typename ExecutionPolicy>
+QueryResult SearchServer::FindTopDocumentsWithin(ExecutionPolicy&& policy, std::string_view raw_query, const QueryDeadline& deadline, DocumentStatus status, size_t max_count, QueryEvaluation evaluation) const {
+    return FindTopDocumentsWithin(policy, raw_query, deadline, [status](int document_id, DocumentStatus document_status, int rating) {
+        return document_status == status;
+    }, max_count, evaluation);
+}
+
+template <typename DocumentPredicate>
+std::future<QueryResult> SearchServer::FindTopDocumentsAsync(ThreadPool& pool, std::string raw_query, QueryDeadline deadline, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation) const {
+    auto result = std::make_shared<std::promise<QueryResult>>();
+    std::future<QueryResult> future = result->get_future();
+    pool.Submit([this, &pool, result, raw_query = std::move(raw_query), deadline = std::move(deadline), document_predicate, max_count, evaluation] {
+        try {
+            result->set_value(FindTopDocumentsWithin(pool.GetPolicy(), raw_query, deadline, document_predicate, max_count, evaluation));
         }
-        else {
-            return lhs.relevance > rhs.relevance;
+        catch (...) {
+            result->set_exception(std::current_exception());
         }
     });
-
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-    }
-
-    return matched_documents;
+    return future;
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
-    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, max_count, evaluation);
 }
 
 template <typename ExecutionPolicy>
-std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status) const {
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, std::string_view raw_query, DocumentStatus status, size_t max_count, QueryEvaluation evaluation) const {
     return FindTopDocuments(policy, raw_query, [&status](int document_id, DocumentStatus new_status, int rating) {
         return new_status == status;
-    });
+    }, max_count, evaluation);
 }
 
 template <typename ExecutionPolicy>
@@ -151,126 +344,514 @@ std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, s
     return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
 }
 
+template <typename ExecutionPolicy>
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(ExecutionPolicy&& policy, const std::vector<std::string>& raw_queries) const {
+    std::vector<Query> queries(raw_queries.size());
+    std::vector<size_t> query_indexes(raw_queries.size());
+    std::vector<const InvertedIndex::PostingList*> heaviest_postings(raw_queries.size());
+    std::iota(query_indexes.begin(), query_indexes.end(), 0);
+    ForEach(policy, query_indexes.begin(), query_indexes.end(), [&](size_t index) {
+        ParseQuery(raw_queries[index], queries[index]);
+        for (auto word : queries[index].plus_words) {
+            const auto* postings = word_to_document_freqs_.Find(word);
+            if (postings != nullptr && (heaviest_postings[index] == nullptr || postings->size() > heaviest_postings[index]->size())) {
+                heaviest_postings[index] = postings;
+            }
+        }
+    });
+
+    // Queries sharing their most expensive term land in the same group.
+    std::sort(query_indexes.begin(), query_indexes.end(), [&heaviest_postings](size_t lhs, size_t rhs) {
+        return std::less<const InvertedIndex::PostingList*>()(heaviest_postings[lhs], heaviest_postings[rhs]);
+    });
+
+    std::vector<std::vector<Document>> results(raw_queries.size());
+    std::vector<size_t> group_begins;
+    for (size_t begin = 0; begin < query_indexes.size(); begin += QUERY_GROUP_SIZE) {
+        group_begins.push_back(begin);
+    }
+    ForEach(policy, group_begins.begin(), group_begins.end(), [&](size_t begin) {
+        const size_t count = std::min<size_t>(QUERY_GROUP_SIZE, query_indexes.size() - begin);
+        FindTopDocumentsInGroup(queries, query_indexes.data() + begin, count, results);
+    });
+    return results;
+}
+
+template<typename DocumentPredicate>
+const TopDocuments& SearchServer::FindAllDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation) const {
+    return FindAllDocuments(std::execution::seq, raw_query, document_predicate, max_count, evaluation, QueryDeadline());
+}
+
+template<typename DocumentPredicate>
+const TopDocuments& SearchServer::FindAllDocuments(const std::execution::sequenced_policy& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation, const QueryDeadline& deadline) const {
+    QueryContext& context = GetQueryContext();
+    {
+        SEARCH_STAGE_TIMER(SearchOperation::FIND_TOP_DOCUMENTS, SearchStage::PARSE);
+        ParseQuery(raw_query, context.query);
+    }
+    context.top_documents.Reset(max_count);
+    context.is_complete = true;
+    if (!document_ids_.empty()) {
+        ScoringTimer timer(SearchOperation::FIND_TOP_DOCUMENTS, false);
+        context.is_complete = FindAllDocumentsInRange(context.query, document_predicate, evaluation, *document_ids_.begin(), *document_ids_.rbegin(), deadline, context.top_documents, timer.GetSampler());
+    }
+    return context.top_documents;
+}
+
+template<typename DocumentPredicate>
+const TopDocuments& SearchServer::FindAllDocuments(const std::execution::parallel_policy& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation, const QueryDeadline& deadline) const {
+    return FindAllDocumentsParallel(policy, raw_query, document_predicate, max_count, evaluation, deadline);
+}
+
+template<typename DocumentPredicate>
+const TopDocuments& SearchServer::FindAllDocuments(const PoolPolicy& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation, const QueryDeadline& deadline) const {
+    return FindAllDocumentsParallel(policy, raw_query, document_predicate, max_count, evaluation, deadline);
+}
+
+template<typename DocumentPredicate, typename ExecutionPolicy>
+const TopDocuments& SearchServer::FindAllDocumentsParallel(const ExecutionPolicy& policy, std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation, const QueryDeadline& deadline) const {
+    QueryContext& context = GetQueryContext();
+    {
+        SEARCH_STAGE_TIMER(SearchOperation::FIND_TOP_DOCUMENTS, SearchStage::PARSE);
+        ParseQuery(raw_query, context.query);
+    }
+    context.top_documents.Reset(max_count);
+    context.is_complete = true;
+    if (document_ids_.empty()) {
+        return context.top_documents;
+    }
+    ScoringTimer timer(SearchOperation::FIND_TOP_DOCUMENTS, true);
+
+    // Every worker scores its own slice of the document id space with its own top, so no
+    // state is shared while scoring and the slices are merged once at the end.
+    const int64_t first_document_id = *document_ids_.begin();
+    const int64_t last_document_id = *document_ids_.rbegin();
+    const int64_t range_count = GetConcurrency(policy) * RANGES_PER_THREAD;
+    const int64_t range_width = (last_document_id - first_document_id) / range_count + 1;
+
+    std::vector<TopDocuments> range_top_documents(range_count, TopDocuments(max_count));
+    std::vector<CandidateSampler> range_samplers(range_count);
+    std::vector<char> range_is_complete(range_count, true);
+    std::vector<int64_t> range_indexes(range_count);
+    std::iota(range_indexes.begin(), range_indexes.end(), 0);
+    ForEach(policy, range_indexes.begin(), range_indexes.end(), [&](int64_t range_index) {
+        const int64_t first = first_document_id + range_index * range_width;
+        const int64_t last = std::min(last_document_id, first + range_width - 1);
+        if (first > last) {
+            return;
+        }
+        // Slices not started before the deadline are skipped entirely.
+        range_is_complete[range_index] = !deadline.IsExpired()
+            && FindAllDocumentsInRange(context.query, document_predicate, evaluation, static_cast<int>(first), static_cast<int>(last), deadline, range_top_documents[range_index], range_samplers[range_index]);
+    });
+    context.is_complete = std::all_of(range_is_complete.begin(), range_is_complete.end(), [](char is_complete) {
+        return is_complete;
+    });
+
+    for (const TopDocuments& range : range_top_documents) {
+        context.top_documents.Merge(range);
+    }
+    for (const CandidateSampler& sampler : range_samplers) {
+        timer.GetSampler().Merge(sampler);
+    }
+    return context.top_documents;
+}
+
+// Document-at-a-time evaluation over documents in [first_document_id, last_document_id].
+// With MAX_SCORE, terms are ordered by their maximal contribution; the cheapest terms that
+// together cannot lift a document into the current top are only probed for candidates
+// produced by the remaining (essential) terms. Relevance is summed in query order, so
+// results are identical to the exhaustive evaluation.
 template<typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
-    const auto query = ParseQuery(raw_query);
-    std::map<int, double> document_to_relevance;
+bool SearchServer::FindAllDocumentsInRange(const Query& query, DocumentPredicate document_predicate, QueryEvaluation evaluation, int first_document_id, int last_document_id, const QueryDeadline& deadline, TopDocuments& top_documents, CandidateSampler& sampler) const {
+    const bool prune = evaluation == QueryEvaluation::MAX_SCORE;
+    QueryContext& context = GetQueryContext();
 
+    auto& cursors = context.cursors;
+    cursors.clear();
     for (auto word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+        const auto* postings = word_to_document_freqs_.Find(word);
+        if (postings == nullptr || postings->empty()) {
             continue;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            const DocumentData& documents_data = documents_.at(document_id);
-            if (document_predicate(document_id, documents_data.status, documents_data.rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
-            }
-        }
+        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word, *postings);
+        cursors.push_back({
+            InvertedIndex::PostingList::Cursor(*postings, postings->LowerBound(0, postings->size(), first_document_id), postings->UpperBound(0, postings->size(), last_document_id)),
+            inverse_document_freq,
+            postings->GetMaxTermFreq() * inverse_document_freq
+        });
     }
-    
+
+    auto& minus_postings = context.minus_postings;
+    minus_postings.clear();
     for (auto word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        for (const auto& [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+        if (const auto* postings = word_to_document_freqs_.Find(word)) {
+            minus_postings.emplace_back(*postings, postings->LowerBound(0, postings->size(), first_document_id), postings->size());
         }
     }
 
-    std::vector<Document> matched_documents;
-    for (auto [document_id, relevance] : document_to_relevance) {
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+    auto& order = context.order;
+    order.resize(cursors.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&cursors](size_t lhs, size_t rhs) {
+        return cursors[lhs].max_relevance < cursors[rhs].max_relevance;
+    });
+    auto& prefix_bounds = context.prefix_bounds;
+    prefix_bounds.resize(order.size());
+    double bound_sum = 0.0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        bound_sum += cursors[order[i]].max_relevance;
+        prefix_bounds[i] = bound_sum;
     }
-    return matched_documents;
-}
 
-template<typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
-    std::map<int, double> document_to_relevance;
-    const auto query = ParseQuery(raw_query);
+    size_t essential_begin = 0;
+    while (prune && essential_begin < order.size() && !top_documents.MayAccept(prefix_bounds[essential_begin])) {
+        ++essential_begin;
+    }
 
-    for (auto word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+    auto& relevances = context.relevances;
+    relevances.resize(cursors.size());
+    // Documents are scored in id order, so when the deadline hits, every document below
+    // the current one has its exact relevance in the top.
+    for (size_t candidate_count = 1;; ++candidate_count) {
+        if (candidate_count % DEADLINE_CHECK_INTERVAL == 0 && deadline.IsExpired()) {
+            return false;
+        }
+        bool has_candidate = false;
+        int document_id = 0;
+        for (size_t i = essential_begin; i < order.size(); ++i) {
+            TermCursor& cursor = cursors[order[i]];
+            if (!cursor.postings.IsAtEnd()) {
+                const int cursor_document_id = cursor.postings.GetDocumentId();
+                if (!has_candidate || cursor_document_id < document_id) {
+                    document_id = cursor_document_id;
+                    has_candidate = true;
+                }
+            }
+        }
+        if (!has_candidate) {
+            break;
+        }
+
+        const DocumentAttributes& attributes = document_attributes_.Get(document_id);
+        double max_relevance = essential_begin > 0 ? prefix_bounds[essential_begin - 1] : 0.0;
+        for (size_t i = essential_begin; i < order.size(); ++i) {
+            TermCursor& cursor = cursors[order[i]];
+            relevances[order[i]] = 0.0;
+            if (!cursor.postings.IsAtEnd() && cursor.postings.GetDocumentId() == document_id) {
+                relevances[order[i]] = ComputeTermFreq(cursor.postings.GetTermCount(), attributes.length) * cursor.inverse_document_freq;
+                max_relevance += relevances[order[i]];
+                cursor.postings.Next();
+            }
+        }
+        if (prune && !top_documents.MayAccept(max_relevance)) {
+            continue;
+        }
+
+        sampler.StartFilter();
+        const bool is_accepted = document_predicate(document_id, attributes.status, attributes.rating)
+            && std::none_of(minus_postings.begin(), minus_postings.end(), [document_id](InvertedIndex::PostingList::Cursor& postings) {
+                postings.SkipTo(document_id);
+                return !postings.IsAtEnd() && postings.GetDocumentId() == document_id;
+            });
+        sampler.FinishFilter();
+        if (!is_accepted) {
             continue;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+
+        for (size_t i = 0; i < essential_begin; ++i) {
+            TermCursor& cursor = cursors[order[i]];
+            cursor.postings.SkipTo(document_id);
+            relevances[order[i]] = 0.0;
+            if (!cursor.postings.IsAtEnd() && cursor.postings.GetDocumentId() == document_id) {
+                relevances[order[i]] = ComputeTermFreq(cursor.postings.GetTermCount(), attributes.length) * cursor.inverse_document_freq;
             }
         }
+
+        const double relevance = std::accumulate(relevances.begin(), relevances.end(), 0.0);
+        sampler.StartTopK();
+        top_documents.Push({ document_id, relevance, attributes.rating });
+        sampler.FinishTopK();
+        while (prune && essential_begin < order.size() && !top_documents.MayAccept(prefix_bounds[essential_begin])) {
+            ++essential_begin;
+        }
     }
+    return true;
+}
 
-    for (auto word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+template <typename ExecutionPolicy>
+std::vector<std::exception_ptr> SearchServer::AddDocuments(ExecutionPolicy&& policy, const std::vector<NewDocument>& documents) {
+    std::vector<WordCounts> word_counts(documents.size());
+    std::vector<std::exception_ptr> parse_errors(documents.size());
+
+    std::vector<size_t> indexes(documents.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+    ForEach(policy, indexes.begin(), indexes.end(), [this, &documents, &word_counts, &parse_errors](size_t index) {
+        try {
+            word_counts[index] = CountWords(documents[index].text);
+        }
+        catch (...) {
+            parse_errors[index] = std::current_exception();
+        }
+    });
+
+    // Documents are accepted in input order with the same checks as AddDocument,
+    // so the outcome matches adding them one by one.
+    std::vector<std::exception_ptr> errors(documents.size());
+    std::vector<InvertedIndex::TermPosting> postings;
+    for (size_t index = 0; index < documents.size(); ++index) {
+        const NewDocument& document = documents[index];
+        try {
+            CheckNewDocument(document.id, document.text);
+            if (parse_errors[index]) {
+                std::rethrow_exception(parse_errors[index]);
+            }
+        }
+        catch (...) {
+            errors[index] = std::current_exception();
             continue;
         }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+
+        const WordCounts& counts = word_counts[index];
+        std::vector<InvertedIndex::TermFrequency> term_freqs;
+        term_freqs.reserve(counts.counts.size());
+        for (const auto [word, term_count] : counts.counts) {
+            const InvertedIndex::TermId term_id = word_to_document_freqs_.AddTerm(word);
+            term_freqs.push_back({ term_id, term_count });
+            postings.push_back({ term_id, document.id, term_count, counts.length });
         }
+        SortByTermId(term_freqs);
+        documents_.emplace(document.id, DocumentData{ StoreText(document.text), std::move(term_freqs) });
+        document_attributes_.Set(document.id, { counts.length, ComputeAverageRating(document.ratings), document.status });
+        document_ids_.emplace(document.id);
+    }
+
+    word_to_document_freqs_.AddPostings(policy, std::move(postings));
+    log_document_count_ = std::log(GetDocumentCount());
+    ++generation_;
+    return errors;
+}
+
+template <typename ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocumentParallel(const ExecutionPolicy& policy, std::string_view raw_query, int document_id) const {
+    if ((document_id < 0) || (documents_.count(document_id) == 0)) {
+        throw std::invalid_argument("document_id out of range"s);
+    }
+
+    Query& query = GetQueryContext().query;
+    {
+        SEARCH_STAGE_TIMER(SearchOperation::MATCH_DOCUMENT, SearchStage::PARSE);
+        ParseQuery(raw_query, query);
     }
 
-    std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance) {
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+    // The query words are already sorted and unique, so the matched words need no
+    // further sorting and the checks can run in parallel.
+    std::vector<std::string_view> matched_words;
+    {
+        SEARCH_STAGE_TIMER(SearchOperation::MATCH_DOCUMENT, SearchStage::TRAVERSAL);
+        const ArrayView<InvertedIndex::TermFrequency> term_freqs = documents_.at(document_id).GetTermFreqs();
+        const auto is_in_document = [this, term_freqs](const std::string_view word) {
+            return HasTerm(term_freqs, word_to_document_freqs_.FindTermId(word));
+        };
+        if (NoneOf(policy, query.minus_words.begin(), query.minus_words.end(), is_in_document)) {
+            matched_words.resize(query.plus_words.size());
+            const auto last = CopyIf(policy, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(), is_in_document);
+            matched_words.erase(last, matched_words.end());
+        }
     }
-    return matched_documents;
+
+    SEARCH_STAGE_TIMER(SearchOperation::MATCH_DOCUMENT, SearchStage::RESULT);
+    return { std::move(matched_words), document_attributes_.Get(document_id).status };
 }
 
-template<typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy& policy, std::string_view raw_query, DocumentPredicate document_predicate) const {
-    ConcurrentMap<int, double> document_to_relevance(BUCKET_COUNT);
-    const auto query = ParseQuery(raw_query);
-
-    std::for_each(policy, query.minus_words.begin(), query.minus_words.end(), [this, &document_to_relevance](std::string_view word) {
-            if (word_to_document_freqs_.count(word)) {
-                for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                    document_to_relevance.Erase(document_id);
-                }
+template <typename ExecutionPolicy>
+DocumentMatches SearchServer::MatchDocuments(ExecutionPolicy&& policy, std::string_view raw_query, const std::vector<int>& document_ids) const {
+    Query& query = GetQueryContext().query;
+    ParseQuery(raw_query, query);
+
+    DocumentMatches matches;
+    matches.document_ids_ = document_ids;
+    matches.statuses_.reserve(document_ids.size());
+    for (const int document_id : document_ids) {
+        const auto it = documents_.find(document_id);
+        if (it == documents_.end()) {
+            throw std::invalid_argument("document_id out of range"s);
+        }
+        matches.statuses_.push_back(document_attributes_.Get(document_id).status);
+    }
+
+    // Words missing from the index cannot match, so only indexed words are checked.
+    std::vector<std::string_view> plus_words;
+    std::vector<const InvertedIndex::PostingList*> plus_postings;
+    for (auto word : query.plus_words) {
+        if (const auto* postings = word_to_document_freqs_.Find(word)) {
+            plus_words.push_back(word);
+            plus_postings.push_back(postings);
+        }
+    }
+    std::vector<const InvertedIndex::PostingList*> minus_postings;
+    for (auto word : query.minus_words) {
+        if (const auto* postings = word_to_document_freqs_.Find(word)) {
+            minus_postings.push_back(postings);
+        }
+    }
+
+    // Every document records its matched words as a bitset over plus_words; the words
+    // are then written to their place in the shared buffer. Documents are checked in
+    // chunks of at least MIN_PARALLEL_MATCH_CHUNK, so small batches stay on the calling
+    // thread instead of paying for task scheduling.
+    const size_t document_count = matches.statuses_.size();
+    const size_t mask_width = (plus_words.size() + 63) / 64;
+    std::vector<uint64_t> masks(document_count * mask_width);
+    matches.word_offsets_.assign(document_count + 1, 0);
+
+    const size_t chunk_count = std::max<size_t>(1, std::min(GetConcurrency(policy) * TASKS_PER_WORKER, document_count / MIN_PARALLEL_MATCH_CHUNK));
+    std::vector<size_t> chunks(chunk_count);
+    std::iota(chunks.begin(), chunks.end(), 0);
+    const auto for_each_document = [&](auto function) {
+        const auto run_chunk = [&](size_t chunk) {
+            const size_t last = document_count * (chunk + 1) / chunk_count;
+            for (size_t index = document_count * chunk / chunk_count; index < last; ++index) {
+                function(index);
+            }
+        };
+        if (chunk_count == 1) {
+            run_chunk(0);
+        }
+        else {
+            ForEach(policy, chunks.begin(), chunks.end(), run_chunk);
+        }
+    };
+
+    for_each_document([&](size_t index) {
+        const int document_id = matches.document_ids_[index];
+        const auto is_in_document = [document_id](const InvertedIndex::PostingList* postings) {
+            return postings->Contains(document_id);
+        };
+        if (std::any_of(minus_postings.begin(), minus_postings.end(), is_in_document)) {
+            return;
+        }
+        uint64_t* mask = masks.data() + index * mask_width;
+        size_t count = 0;
+        for (size_t word = 0; word < plus_postings.size(); ++word) {
+            if (is_in_document(plus_postings[word])) {
+                mask[word / 64] |= uint64_t{ 1 } << (word % 64);
+                ++count;
             }
+        }
+        matches.word_offsets_[index + 1] = count;
     });
 
-    std::for_each(policy, query.plus_words.begin(), query.plus_words.end(), [this, &document_predicate, &document_to_relevance](std::string_view word) {
-            if (word_to_document_freqs_.count(word)) {
-                const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                    const auto& document_data = documents_.at(document_id);
-                    if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                        document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
-                    }
-                }
+    std::partial_sum(matches.word_offsets_.begin(), matches.word_offsets_.end(), matches.word_offsets_.begin());
+    matches.words_.resize(matches.word_offsets_.back());
+    for_each_document([&](size_t index) {
+        if (matches.word_offsets_[index] == matches.word_offsets_[index + 1]) {
+            return;
+        }
+        const uint64_t* mask = masks.data() + index * mask_width;
+        auto output = matches.words_.begin() + matches.word_offsets_[index];
+        for (size_t word = 0; word < plus_words.size(); ++word) {
+            if (mask[word / 64] >> (word % 64) & 1) {
+                *output++ = plus_words[word];
             }
+        }
     });
+    return matches;
+}
 
-    std::map<int, double> document_to_relevance_reduced = document_to_relevance.BuildOrdinaryMap();
-    std::vector<Document> matched_documents;
-    matched_documents.reserve(document_to_relevance_reduced.size());
+template <typename ExecutionPolicy>
+void SearchServer::RemoveDocument(ExecutionPolicy&& policy, int document_id) {
+    const auto it = documents_.find(document_id);
+    if (it != documents_.end()) {
+        CheckTermFreqs(it->second);
+        const ArrayView<InvertedIndex::TermFrequency> term_freqs = it->second.GetTermFreqs();
+        std::vector<InvertedIndex::TermId> term_ids(term_freqs.size());
+
+        Transform(policy, term_freqs.begin(), term_freqs.end(), term_ids.begin(), [](const InvertedIndex::TermFrequency& entry) {
+            return entry.term_id;
+        });
 
-    for (const auto [document_id, relevance] : document_to_relevance_reduced) {
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+        word_to_document_freqs_.RemovePostings(policy, term_ids, document_id);
+
+        documents_.erase(it);
+        document_attributes_.Erase(document_id);
+        document_ids_.erase(document_id);
+        log_document_count_ = std::log(GetDocumentCount());
+        ++generation_;
     }
-    return matched_documents;
 }
 
-
 template <typename ExecutionPolicy>
-void SearchServer::RemoveDocument(ExecutionPolicy&& policy, int document_id) {
-    if (document_to_word_freqs_.count(document_id)) {
-        const std::map<std::string_view, double>& word_freqs = document_to_word_freqs_.at(document_id);
-        std::vector<std::string*> words(word_freqs.size());
-
-        std::transform(policy, word_freqs.begin(), word_freqs.end(), words.begin(), [](const auto& item) { 
-            return &item.first; 
-        });
+void SearchServer::RemoveDocuments(ExecutionPolicy&& policy, const std::vector<int>& document_ids) {
+    std::vector<int> removed_ids;
+    std::copy_if(document_ids.begin(), document_ids.end(), std::back_inserter(removed_ids), [this](int document_id) {
+        return documents_.count(document_id) > 0;
+    });
+    Sort(policy, removed_ids.begin(), removed_ids.end());
+    removed_ids.erase(std::unique(removed_ids.begin(), removed_ids.end()), removed_ids.end());
+    if (removed_ids.empty()) {
+        return;
+    }
 
-        std::for_each(policy, words.begin(), words.end(), [this, document_id](std::string* item) {
-            word_to_document_freqs_.at(*item).erase(document_id);
-        });
+    std::vector<InvertedIndex::TermPosting> postings;
+    for (const int document_id : removed_ids) {
+        CheckTermFreqs(documents_.at(document_id));
+    }
+    for (const int document_id : removed_ids) {
+        for (const InvertedIndex::TermFrequency& entry : documents_.at(document_id).GetTermFreqs()) {
+            postings.push_back({ entry.term_id, document_id, entry.term_count, 0 });
+        }
+    }
+    word_to_document_freqs_.RemovePostings(policy, std::move(postings));
 
-        document_to_word_freqs_.erase(document_id);
+    for (const int document_id : removed_ids) {
         documents_.erase(document_id);
+        document_attributes_.Erase(document_id);
         document_ids_.erase(document_id);
     }
-}
\ No newline at end of file
+    log_document_count_ = std::log(GetDocumentCount());
+    ++generation_;
+}
+
+// Documents are sorted by a 128-bit fingerprint of their term set; only documents with
+// equal fingerprints are compared term by term, so no word set is ever materialized.
+template <typename ExecutionPolicy>
+std::vector<int> SearchServer::FindDuplicates(ExecutionPolicy&& policy) const {
+    struct Entry {
+        TermSetFingerprint fingerprint;
+        int document_id;
+        ArrayView<InvertedIndex::TermFrequency> term_freqs;
+    };
+    std::vector<Entry> entries;
+    entries.reserve(documents_.size());
+    for (const auto& [document_id, document_data] : documents_) {
+        entries.push_back({ {}, document_id, document_data.GetTermFreqs() });
+    }
+
+    ForEach(policy, entries.begin(), entries.end(), [](Entry& entry) {
+        entry.fingerprint = ComputeTermSetFingerprint(entry.term_freqs);
+    });
+    Sort(policy, entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+        return std::tie(lhs.fingerprint.high, lhs.fingerprint.low, lhs.document_id) < std::tie(rhs.fingerprint.high, rhs.fingerprint.low, rhs.document_id);
+    });
+
+    std::vector<int> duplicates;
+    for (size_t run_begin = 0, run_end = 0; run_begin < entries.size(); run_begin = run_end) {
+        const TermSetFingerprint& fingerprint = entries[run_begin].fingerprint;
+        run_end = run_begin + 1;
+        while (run_end < entries.size() && entries[run_end].fingerprint.high == fingerprint.high && entries[run_end].fingerprint.low == fingerprint.low) {
+            ++run_end;
+        }
+        // The lowest id of each distinct term set comes first and is kept.
+        for (size_t i = run_begin + 1; i < run_end; ++i) {
+            for (size_t original = run_begin; original < i; ++original) {
+                if (HaveSameTerms(entries[original].term_freqs, entries[i].term_freqs)) {
+                    duplicates.push_back(entries[i].document_id);
+                    break;
+                }
+            }
+        }
+    }
+    Sort(policy, duplicates.begin(), duplicates.end());
+    return duplicates;
+}
@@ -0,0 +1,583 @@
+#include "concurrent_search_server.h"
+#include "query_cache.h"
+#include "request_queue.h"
+#include "search_server.h"
+#include "snapshot.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <execution>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+int failure_count = 0;
+
+template <typename T>
+ostream& operator<<(ostream& out, const vector<T>& values) {
+    out << '[';
+    for (size_t i = 0; i < values.size(); ++i) {
+        out << (i > 0 ? ", " : "") << values[i];
+    }
+    return out << ']';
+}
+
+template <typename T, typename U>
+void AssertEqualImpl(const T& t, const U& u, const string& t_str, const string& u_str, const string& file, unsigned line) {
+    if (!(t == u)) {
+        cerr << file << "("s << line << "): ASSERT_EQUAL("s << t_str << ", "s << u_str << ") failed: "s << t << " != "s << u << endl;
+        ++failure_count;
+    }
+}
+
+void AssertImpl(bool value, const string& expr_str, const string& file, unsigned line) {
+    if (!value) {
+        cerr << file << "("s << line << "): ASSERT("s << expr_str << ") failed."s << endl;
+        ++failure_count;
+    }
+}
+
+template <typename Function>
+void AssertThrowsImpl(Function function, const string& expr_str, const string& file, unsigned line) {
+    try {
+        function();
+    }
+    catch (const exception&) {
+        return;
+    }
+    cerr << file << "("s << line << "): ASSERT_THROWS("s << expr_str << ") failed: nothing thrown."s << endl;
+    ++failure_count;
+}
+
+#define ASSERT_EQUAL(a, b) AssertEqualImpl((a), (b), #a, #b, __FILE__, __LINE__)
+#define ASSERT(expr) AssertImpl(!!(expr), #expr, __FILE__, __LINE__)
+#define ASSERT_THROWS(expr) AssertThrowsImpl([&] { expr; }, #expr, __FILE__, __LINE__)
+
+template <typename Function>
+void RunTestImpl(Function function, const string& name) {
+    const int failures_before = failure_count;
+    function();
+    cerr << name << (failure_count == failures_before ? " OK"s : " FAILED"s) << endl;
+}
+
+#define RUN_TEST(func) RunTestImpl((func), #func)
+
+bool IsNear(double lhs, double rhs) {
+    return abs(lhs - rhs) < EPS;
+}
+
+vector<int> GetIds(const vector<Document>& documents) {
+    vector<int> ids;
+    for (const Document& document : documents) {
+        ids.push_back(document.id);
+    }
+    return ids;
+}
+
+// Words are counted without stop words, so document lengths are 4, 4, 4 and 3.
+SearchServer MakeServer() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+    search_server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    search_server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 5, -12, 2, 1 });
+    search_server.AddDocument(4, "groomed starling eugene"s, DocumentStatus::BANNED, { 9 });
+    return search_server;
+}
+
+void TestExcludeStopWords() {
+    SearchServer search_server("in the"s);
+    search_server.AddDocument(42, "cat in the city"s, DocumentStatus::ACTUAL, { 1, 2, 3 });
+    ASSERT(search_server.FindTopDocuments("in"s).empty());
+    ASSERT_EQUAL(search_server.FindTopDocuments("cat"s).size(), 1u);
+}
+
+void TestExcludeMinusWords() {
+    const SearchServer search_server = MakeServer();
+    ASSERT_EQUAL(GetIds(search_server.FindTopDocuments("fluffy groomed cat -collar"s)), (vector<int>{ 2, 3 }));
+    ASSERT(search_server.FindTopDocuments("cat -cat"s).empty());
+}
+
+void TestRelevanceOrdering() {
+    const SearchServer search_server = MakeServer();
+    const vector<Document> documents = search_server.FindTopDocuments("fluffy groomed cat"s);
+    // Documents 1 and 3 are equally relevant, so the higher rating comes first.
+    ASSERT_EQUAL(GetIds(documents), (vector<int>{ 2, 1, 3 }));
+    ASSERT(IsNear(documents[0].relevance, 0.5 * log(4.0) + 0.25 * log(2.0)));
+    ASSERT(IsNear(documents[1].relevance, 0.25 * log(2.0)));
+    ASSERT(IsNear(documents[2].relevance, 0.25 * log(2.0)));
+
+    const vector<Document> max_score = search_server.FindTopDocuments("fluffy groomed cat"s, DocumentStatus::ACTUAL, MAX_RESULT_DOCUMENT_COUNT, QueryEvaluation::MAX_SCORE);
+    ASSERT_EQUAL(GetIds(max_score), GetIds(documents));
+    ASSERT_EQUAL(GetIds(search_server.FindTopDocuments("fluffy groomed cat"s, DocumentStatus::ACTUAL, 2)), (vector<int>{ 2, 1 }));
+}
+
+void TestRating() {
+    const SearchServer search_server = MakeServer();
+    const vector<Document> documents = search_server.FindTopDocuments("fluffy groomed cat"s);
+    ASSERT_EQUAL(documents[0].rating, (7 + 2 + 7) / 3);
+    ASSERT_EQUAL(documents[1].rating, (8 - 3) / 2);
+    ASSERT_EQUAL(documents[2].rating, (5 - 12 + 2 + 1) / 4);
+}
+
+void TestStatusAndPredicateFiltering() {
+    const SearchServer search_server = MakeServer();
+    ASSERT_EQUAL(GetIds(search_server.FindTopDocuments("fluffy groomed cat"s, DocumentStatus::BANNED)), (vector<int>{ 4 }));
+    ASSERT(search_server.FindTopDocuments("fluffy groomed cat"s, DocumentStatus::REMOVED).empty());
+
+    const auto is_even = [](int document_id, DocumentStatus status, int rating) {
+        return document_id % 2 == 0;
+    };
+    ASSERT_EQUAL(GetIds(search_server.FindTopDocuments("fluffy groomed cat"s, is_even)), (vector<int>{ 2, 4 }));
+    ASSERT_EQUAL(GetIds(search_server.FindTopDocuments(execution::par, "fluffy groomed cat"s, is_even)), (vector<int>{ 2, 4 }));
+}
+
+// Matched words are views into the query, so the query must outlive them.
+void TestMatchDocument() {
+    const SearchServer search_server = MakeServer();
+    const string query = "fluffy cat collar dog"s;
+    {
+        const auto [words, status] = search_server.MatchDocument(query, 2);
+        ASSERT_EQUAL(words, (vector<string_view>{ "cat"sv, "fluffy"sv }));
+        ASSERT(status == DocumentStatus::ACTUAL);
+    }
+    {
+        const auto [words, status] = search_server.MatchDocument(execution::par, query, 2);
+        ASSERT_EQUAL(words, (vector<string_view>{ "cat"sv, "fluffy"sv }));
+    }
+    {
+        const auto [words, status] = search_server.MatchDocument("groomed cat -eugene"s, 4);
+        ASSERT(words.empty());
+        ASSERT(status == DocumentStatus::BANNED);
+    }
+
+    const string batch_query = "groomed cat -collar"s;
+    const DocumentMatches matches = search_server.MatchDocuments(execution::par, batch_query, { 1, 2, 3, 4 });
+    ASSERT_EQUAL(matches.size(), 4u);
+    const vector<vector<string_view>> expected = { {}, { "cat"sv }, { "groomed"sv }, { "groomed"sv } };
+    for (size_t i = 0; i < matches.size(); ++i) {
+        const auto words = matches.GetWords(i);
+        ASSERT_EQUAL(vector<string_view>(words.begin(), words.end()), expected[i]);
+    }
+    ASSERT_THROWS(search_server.MatchDocument("cat"s, 5));
+}
+
+// Large enough for the parallel version to split the documents into chunks.
+void TestMatchDocumentsInChunks() {
+    SearchServer search_server("and"s);
+    vector<string> texts;
+    for (int id = 0; id < 5 * MIN_PARALLEL_MATCH_CHUNK; ++id) {
+        texts.push_back("a"s + to_string(id % 7) + " b"s + to_string(id % 11) + " c"s + to_string(id % 13));
+        search_server.AddDocument(id, texts.back(), DocumentStatus::ACTUAL, { id % 5 });
+    }
+    const vector<int> document_ids(search_server.begin(), search_server.end());
+    const string query = "a1 b2 c3 -c4"s;
+    const DocumentMatches sequential = search_server.MatchDocuments(execution::seq, query, document_ids);
+    const DocumentMatches parallel = search_server.MatchDocuments(execution::par, query, document_ids);
+    ASSERT_EQUAL(parallel.size(), document_ids.size());
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        const auto [words, status] = search_server.MatchDocument(query, document_ids[i]);
+        const auto sequential_words = sequential.GetWords(i);
+        const auto parallel_words = parallel.GetWords(i);
+        ASSERT_EQUAL(parallel.GetDocumentId(i), document_ids[i]);
+        ASSERT_EQUAL(vector<string_view>(sequential_words.begin(), sequential_words.end()), words);
+        ASSERT_EQUAL(vector<string_view>(parallel_words.begin(), parallel_words.end()), words);
+    }
+}
+
+void TestRemoveDocument() {
+    SearchServer search_server = MakeServer();
+    search_server.RemoveDocument(2);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 3);
+    ASSERT(search_server.FindTopDocuments("fluffy"s).empty());
+    ASSERT_EQUAL(GetIds(search_server.FindTopDocuments("cat"s)), (vector<int>{ 1 }));
+    search_server.RemoveDocument(execution::par, 1);
+    ASSERT(search_server.FindTopDocuments("cat"s).empty());
+}
+
+// Documents added out of id order and removed from the middle change posting lists one
+// block at a time; the index must answer as one built from the remaining documents.
+void TestRemoveAndAddInsidePostingLists() {
+    const auto text = [](int id) {
+        return "common w"s + to_string(id % 7);
+    };
+    SearchServer search_server(""s);
+    for (int id = 0; id < 1000; id += 2) {
+        search_server.AddDocument(id, text(id), DocumentStatus::ACTUAL, { id });
+    }
+    for (int id = 1; id < 1000; id += 2) {
+        search_server.AddDocument(id, text(id), DocumentStatus::ACTUAL, { id });
+    }
+    SearchServer expected_server(""s);
+    for (int id = 0; id < 1000; ++id) {
+        if (id % 3 == 0) {
+            search_server.RemoveDocument(id);
+        }
+        else {
+            expected_server.AddDocument(id, text(id), DocumentStatus::ACTUAL, { id });
+        }
+    }
+
+    ASSERT_EQUAL(search_server.GetDocumentCount(), expected_server.GetDocumentCount());
+    const auto is_sparse = [](int document_id, DocumentStatus, int) {
+        return document_id % 50 == 7;
+    };
+    for (const string& query : { "common"s, "w3"s, "common -w2"s }) {
+        ASSERT_EQUAL(GetIds(search_server.FindTopDocuments(query)), GetIds(expected_server.FindTopDocuments(query)));
+        ASSERT_EQUAL(GetIds(search_server.FindTopDocuments(query, is_sparse)), GetIds(expected_server.FindTopDocuments(query, is_sparse)));
+    }
+}
+
+// Documents added under ever larger ids and removed in the order they came must not leave
+// per-id state behind once the server is compacted.
+void TestChurnKeepsMemoryFlat() {
+    const int window = 3000;
+    SearchServer search_server(""s);
+    int next_id = 0;
+    for (; next_id < window; ++next_id) {
+        search_server.AddDocument(next_id, "common w"s + to_string(next_id % 7), DocumentStatus::ACTUAL, { 1 });
+    }
+    vector<size_t> memory_usages;
+    for (int round = 0; round < 8; ++round) {
+        for (int i = 0; i < window / 2; ++i, ++next_id) {
+            search_server.RemoveDocument(next_id - window);
+            search_server.AddDocument(next_id, "common w"s + to_string(next_id % 7), DocumentStatus::ACTUAL, { 1 });
+        }
+        search_server.Compact();
+        memory_usages.push_back(search_server.GetMemoryUsage());
+    }
+    ASSERT_EQUAL(search_server.GetDocumentCount(), window);
+    ASSERT(memory_usages.back() <= memory_usages[1]);
+    const int last_id = next_id - 1;
+    ASSERT_EQUAL(GetIds(search_server.FindTopDocuments("w"s + to_string(last_id % 7), [last_id](int document_id, DocumentStatus, int) {
+        return document_id == last_id;
+    })), (vector<int>{ last_id }));
+}
+
+void TestWordFrequencies() {
+    const SearchServer search_server = MakeServer();
+    vector<pair<string_view, double>> frequencies;
+    for (const auto [word, frequency] : search_server.GetWordFrequencies(2)) {
+        frequencies.emplace_back(word, frequency);
+    }
+    ASSERT_EQUAL(frequencies.size(), 3u);
+    ASSERT(frequencies[0].first == "cat"sv && IsNear(frequencies[0].second, 0.25));
+    ASSERT(frequencies[1].first == "fluffy"sv && IsNear(frequencies[1].second, 0.5));
+    ASSERT(frequencies[2].first == "tail"sv && IsNear(frequencies[2].second, 0.25));
+
+    // "groomed" was interned by document 3, before the other words of document 4.
+    vector<string_view> words;
+    for (const auto [word, frequency] : search_server.GetWordFrequencies(4)) {
+        words.push_back(word);
+    }
+    ASSERT_EQUAL(words, (vector<string_view>{ "eugene"sv, "groomed"sv, "starling"sv }));
+
+    // Lookups and ForEachWord take the forward index as it is, in term id order.
+    const WordFrequencies word_freqs = search_server.GetWordFrequencies(4);
+    ASSERT_EQUAL(word_freqs.count("starling"sv), 1u);
+    ASSERT(IsNear(word_freqs.at("eugene"sv), 1.0 / 3));
+    words.clear();
+    word_freqs.ForEachWord([&words](string_view word, double frequency) {
+        words.push_back(word);
+    });
+    ASSERT_EQUAL(words, (vector<string_view>{ "groomed"sv, "eugene"sv, "starling"sv }));
+}
+
+void TestInvalidInput() {
+    SearchServer search_server = MakeServer();
+    ASSERT_THROWS(search_server.AddDocument(-1, "cat"s, DocumentStatus::ACTUAL, { 1 }));
+    ASSERT_THROWS(search_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, { 1 }));
+    ASSERT_THROWS(search_server.AddDocument(5, "big c\x12t"s, DocumentStatus::ACTUAL, { 1 }));
+    ASSERT_THROWS(search_server.FindTopDocuments("--cat"s));
+    ASSERT_THROWS(search_server.FindTopDocuments("cat -"s));
+    ASSERT_THROWS(SearchServer("in th\x12"s));
+}
+
+void AssertSameResults(const SearchServer& actual_server, const SearchServer& expected_server) {
+    ASSERT_EQUAL(actual_server.GetDocumentCount(), expected_server.GetDocumentCount());
+    ASSERT_EQUAL(actual_server.GetTermCount(), expected_server.GetTermCount());
+    ASSERT_EQUAL(actual_server.GetPostingCount(), expected_server.GetPostingCount());
+    for (const string& query : { "fluffy groomed cat"s, "groomed -dog"s, "and collar"s, "parrot cat"s }) {
+        const vector<Document> expected = expected_server.FindTopDocuments(query);
+        const vector<Document> actual = actual_server.FindTopDocuments(query);
+        ASSERT_EQUAL(GetIds(actual), GetIds(expected));
+        for (size_t i = 0; i < min(expected.size(), actual.size()); ++i) {
+            ASSERT(expected[i].relevance == actual[i].relevance);
+        }
+    }
+}
+
+void TestSnapshot() {
+    SearchServer search_server = MakeServer();
+    search_server.AddDocument(5, "and with"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(6, "eugene groomed starling"s, DocumentStatus::ACTUAL, { 2 });
+    const string path = "search_server_tests.snapshot"s;
+    search_server.SaveSnapshot(path);
+    SearchServer loaded = SearchServer::LoadSnapshot(path);
+    remove(path.c_str());
+
+    AssertSameResults(loaded, search_server);
+    ASSERT_EQUAL(get<0>(loaded.MatchDocument("fluffy tail -dog"s, 2)), (vector<string_view>{ "fluffy"sv, "tail"sv }));
+    ASSERT(IsNear(loaded.GetWordFrequencies(2).at("fluffy"s), 0.5));
+    ASSERT_EQUAL(loaded.FindDuplicates(), (vector<int>{ 6 }));
+
+    // Changes copy the terms they reach out of the mapping.
+    for (SearchServer* server : { &search_server, &loaded }) {
+        server->RemoveDocument(2);
+        server->RemoveDocuments({ 3, 4 });
+        server->AddDocument(7, "fluffy parrot and groomed tail"s, DocumentStatus::ACTUAL, { 4 });
+        server->AddDocument(8, "expressive parrot"s, DocumentStatus::ACTUAL, { 3 });
+        server->Compact();
+    }
+    AssertSameResults(loaded, search_server);
+    ASSERT(loaded.FindDuplicates().empty());
+
+    loaded.SaveSnapshot(path);
+    const SearchServer reloaded = SearchServer::LoadSnapshot(path);
+    remove(path.c_str());
+    AssertSameResults(reloaded, search_server);
+}
+
+struct SnapshotDocument {
+    int32_t id;
+    int32_t status;
+    uint32_t length;
+};
+
+// Writes a snapshot of the given documents, all with the text "cat", and one term "cat"
+// with the given postings. Documents of positive length list the term.
+void WriteSnapshot(const string& path, const vector<SnapshotDocument>& documents, const vector<int32_t>& posting_ids) {
+    const InvertedIndex::TermFrequency cat_entry{ InvertedIndex::FIRST_MAPPED_TERM, 1 };
+    vector<SnapshotDocumentRecord> records;
+    vector<InvertedIndex::TermFrequency> forward_index;
+    for (const SnapshotDocument& document : documents) {
+        records.push_back({ document.id, 0, document.status, document.length, 0, 3, forward_index.size(), document.length > 0 ? 1u : 0u });
+        if (document.length > 0) {
+            forward_index.push_back(cat_entry);
+        }
+    }
+    vector<Posting> postings;
+    for (const int32_t document_id : posting_ids) {
+        postings.push_back({ document_id, 1 });
+    }
+
+    ofstream output(path, ios::binary);
+    SnapshotWriter writer(output);
+    writer.WriteHeader();
+    writer.Write<uint64_t>(0);
+    writer.WriteArray(records);
+    writer.WriteArray(vector<char>{ 'c', 'a', 't' });
+    writer.WriteArray(forward_index);
+    writer.WriteArray(vector<SnapshotTermRecord>{ { 0, 0, 3, static_cast<uint32_t>(postings.size()) } });
+    writer.WriteArray(vector<char>{ 'c', 'a', 't' });
+    writer.WriteArray(postings);
+}
+
+void TestCorruptedSnapshot() {
+    const string path = "search_server_tests_corrupted.snapshot"s;
+    WriteSnapshot(path, { { 1, 0, 1 }, { 2, 0, 1 } }, { 1, 2 });
+    ASSERT_EQUAL(GetIds(SearchServer::LoadSnapshot(path).FindTopDocuments("cat"s)), (vector<int>{ 1, 2 }));
+
+    WriteSnapshot(path, { { -1, 0, 1 } }, { -1 });
+    ASSERT_THROWS(SearchServer::LoadSnapshot(path));
+    WriteSnapshot(path, { { 2, 0, 1 }, { 1, 0, 1 } }, { 1, 2 });
+    ASSERT_THROWS(SearchServer::LoadSnapshot(path));
+    WriteSnapshot(path, { { 1, 0, 1 }, { 1, 0, 1 } }, { 1 });
+    ASSERT_THROWS(SearchServer::LoadSnapshot(path));
+    WriteSnapshot(path, { { 1, 4, 1 } }, { 1 });
+    ASSERT_THROWS(SearchServer::LoadSnapshot(path));
+    WriteSnapshot(path, { { 1, 0, 1 }, { 2, 0, 0 } }, { 1 });
+    ASSERT_EQUAL(GetIds(SearchServer::LoadSnapshot(path).FindTopDocuments("cat"s)), (vector<int>{ 1 }));
+
+    // Posting lists are checked when a query first reads them.
+    WriteSnapshot(path, { { 1, 0, 0 } }, { 1 });
+    ASSERT_THROWS(SearchServer::LoadSnapshot(path).FindTopDocuments("cat"s));
+    WriteSnapshot(path, { { 1, 0, 1 }, { 2, 0, 1 } }, { 1, 1, 2 });
+    ASSERT_THROWS(SearchServer::LoadSnapshot(path).FindTopDocuments("cat"s));
+    WriteSnapshot(path, { { 1, 0, 1 }, { 2, 0, 1 } }, { 1, 3 });
+    ASSERT_THROWS(SearchServer::LoadSnapshot(path).FindTopDocuments("cat"s));
+    WriteSnapshot(path, { { 1, 0, 1 } }, {});
+    ASSERT_THROWS(SearchServer::LoadSnapshot(path).FindTopDocuments("cat"s));
+    remove(path.c_str());
+}
+
+void TestConcurrentReadsDuringWrites() {
+    ConcurrentSearchServer search_server("and with"s);
+    search_server.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+    search_server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    search_server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, { 5, -12, 2, 1 });
+
+    // Readers see the parrot either fully added or fully removed.
+    atomic<bool> is_done = false;
+    atomic<int> inconsistent_reads = 0;
+    vector<thread> readers;
+    for (int reader = 0; reader < 2; ++reader) {
+        readers.emplace_back([&] {
+            while (!is_done) {
+                vector<int> ids = GetIds(search_server.FindTopDocuments("fluffy groomed cat"s));
+                sort(ids.begin(), ids.end());
+                const vector<int> parrot_ids = GetIds(search_server.FindTopDocuments("purple parrot"s));
+                if (ids != vector<int>{ 1, 2, 3 } || (!parrot_ids.empty() && parrot_ids != vector<int>{ 100 })) {
+                    ++inconsistent_reads;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < 200; ++i) {
+        search_server.AddDocument(100, "purple parrot"s, DocumentStatus::ACTUAL, { 1 });
+        search_server.RemoveDocument(100);
+    }
+    is_done = true;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQUAL(inconsistent_reads.load(), 0);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 3);
+    ASSERT(search_server.FindTopDocuments("purple parrot"s).empty());
+}
+
+void TestQueryCacheAfterWrite() {
+    SearchServer search_server = MakeServer();
+    QueryCache cache(16);
+    ASSERT_EQUAL(GetIds(cache.FindTopDocuments(search_server, "fluffy cat"s)), (vector<int>{ 2, 1 }));
+    ASSERT_EQUAL(GetIds(cache.FindTopDocuments(search_server, "cat fluffy"s)), (vector<int>{ 2, 1 }));
+    ASSERT_EQUAL(cache.GetHitCount(), 1u);
+
+    search_server.AddDocument(5, "fluffy fluffy cat"s, DocumentStatus::ACTUAL, { 9 });
+    ASSERT_EQUAL(GetIds(cache.FindTopDocuments(search_server, "fluffy cat"s)), GetIds(search_server.FindTopDocuments("fluffy cat"s)));
+    search_server.RemoveDocument(2);
+    ASSERT_EQUAL(GetIds(cache.FindTopDocuments(search_server, "fluffy cat"s)), GetIds(search_server.FindTopDocuments("fluffy cat"s)));
+    ASSERT_EQUAL(cache.GetHitCount(), 1u);
+    ASSERT_EQUAL(cache.GetMissCount(), 3u);
+}
+
+void TestRequestQueue() {
+    const SearchServer search_server = MakeServer();
+    RequestQueue window(search_server, nullptr, 3);
+    window.AddFindRequest("nosuchword"s);
+    window.AddFindRequest("nosuchword"s);
+    window.AddFindRequest("cat"s);
+    ASSERT_EQUAL(window.GetNoResultRequests(), 2);
+    window.AddFindRequest("dog"s);
+    ASSERT_EQUAL(window.GetNoResultRequests(), 1);
+    window.AddFindRequest("nosuchword"s);
+    ASSERT_EQUAL(window.GetNoResultRequests(), 1);
+
+    RequestQueue request_queue(search_server);
+    vector<thread> workers;
+    for (int worker = 0; worker < 4; ++worker) {
+        workers.emplace_back([&request_queue] {
+            for (int i = 0; i < 100; ++i) {
+                request_queue.AddFindRequest(i % 2 == 0 ? "nosuchword"s : "cat"s);
+            }
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    ASSERT_EQUAL(request_queue.GetNoResultRequests(), 200);
+}
+
+void TestThreadPool() {
+    ThreadPool pool(2);
+    atomic<size_t> sum = 0;
+    pool.ParallelFor(1000, [&sum](size_t i) {
+        sum += i;
+    });
+    ASSERT_EQUAL(sum.load(), 499500u);
+    ASSERT_THROWS(pool.ParallelFor(10, [](size_t i) {
+        if (i == 7) {
+            throw runtime_error("task failed"s);
+        }
+    }));
+
+    promise<int> result;
+    pool.Submit([&result] {
+        result.set_value(42);
+    });
+    ASSERT_EQUAL(result.get_future().get(), 42);
+
+    const SearchServer search_server = MakeServer();
+    for (const string& query : { "fluffy groomed cat"s, "groomed -dog"s }) {
+        ASSERT_EQUAL(GetIds(search_server.FindTopDocuments(pool.GetPolicy(), query)), GetIds(search_server.FindTopDocuments(query)));
+    }
+    ASSERT_EQUAL(get<0>(search_server.MatchDocument(pool.GetPolicy(), "fluffy tail -dog"s, 2)), (vector<string_view>{ "fluffy"sv, "tail"sv }));
+}
+
+void TestFindTopDocumentsBatch() {
+    const SearchServer search_server = MakeServer();
+    const vector<string> queries = { "fluffy groomed cat"s, "groomed -dog"s, "nosuchword"s, "cat -cat"s, "fluffy groomed cat"s, "and collar"s };
+    ThreadPool pool(2);
+    for (const auto& results : { search_server.FindTopDocumentsBatch(execution::seq, queries), search_server.FindTopDocumentsBatch(pool.GetPolicy(), queries) }) {
+        ASSERT_EQUAL(results.size(), queries.size());
+        for (size_t i = 0; i < min(results.size(), queries.size()); ++i) {
+            const vector<Document> expected = search_server.FindTopDocuments(queries[i]);
+            ASSERT_EQUAL(GetIds(results[i]), GetIds(expected));
+            for (size_t j = 0; j < min(expected.size(), results[i].size()); ++j) {
+                ASSERT(IsNear(results[i][j].relevance, expected[j].relevance));
+            }
+        }
+    }
+}
+
+// Threads retire their histograms on exit; their counts must stay in the snapshots.
+void TestLatencyHistogramsOfExitedThreads() {
+#ifndef SEARCH_SERVER_DISABLE_METRICS
+    ResetLatencyHistograms();
+    const size_t thread_count = 8;
+    const size_t record_count = 1000;
+    for (int round = 0; round < 2; ++round) {
+        vector<thread> threads;
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads.emplace_back([record_count] {
+                for (size_t j = 0; j < record_count; ++j) {
+                    RecordLatency(SearchOperation::MATCH_DOCUMENT, SearchStage::FILTER, chrono::nanoseconds(j));
+                }
+            });
+        }
+        for (thread& worker : threads) {
+            worker.join();
+        }
+    }
+    const LatencySnapshot snapshot = GetLatencySnapshot(SearchOperation::MATCH_DOCUMENT, SearchStage::FILTER);
+    ASSERT_EQUAL(snapshot.count, 2 * thread_count * record_count);
+    ASSERT(snapshot.max >= chrono::nanoseconds(record_count - 1));
+    ResetLatencyHistograms();
+    ASSERT_EQUAL(GetLatencySnapshot(SearchOperation::MATCH_DOCUMENT, SearchStage::FILTER).count, 0u);
+#endif
+}
+
+}
+
+int main() {
+    RUN_TEST(TestExcludeStopWords);
+    RUN_TEST(TestExcludeMinusWords);
+    RUN_TEST(TestRelevanceOrdering);
+    RUN_TEST(TestRating);
+    RUN_TEST(TestStatusAndPredicateFiltering);
+    RUN_TEST(TestMatchDocument);
+    RUN_TEST(TestMatchDocumentsInChunks);
+    RUN_TEST(TestRemoveDocument);
+    RUN_TEST(TestRemoveAndAddInsidePostingLists);
+    RUN_TEST(TestChurnKeepsMemoryFlat);
+    RUN_TEST(TestWordFrequencies);
+    RUN_TEST(TestInvalidInput);
+    RUN_TEST(TestSnapshot);
+    RUN_TEST(TestCorruptedSnapshot);
+    RUN_TEST(TestConcurrentReadsDuringWrites);
+    RUN_TEST(TestQueryCacheAfterWrite);
+    RUN_TEST(TestRequestQueue);
+    RUN_TEST(TestThreadPool);
+    RUN_TEST(TestFindTopDocumentsBatch);
+    RUN_TEST(TestLatencyHistogramsOfExitedThreads);
+    return failure_count == 0 ? 0 : 1;
+}
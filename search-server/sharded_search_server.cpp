@@ -0,0 +1,106 @@
+#include "sharded_search_server.h"
+
+#include <algorithm>
+#include <thread>
+
+ShardedSearchServer::ShardedSearchServer(const std::string& stop_words_text, size_t shard_count, size_t worker_count)
+    : ShardedSearchServer(SplitIntoWords(stop_words_text), shard_count, worker_count) {
+}
+
+ShardedSearchServer::ShardedSearchServer(std::string_view stop_words_text, size_t shard_count, size_t worker_count)
+    : ShardedSearchServer(SplitIntoWordsView(stop_words_text), shard_count, worker_count) {
+}
+
+void ShardedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    if (document_id < 0) {
+        throw std::invalid_argument("document_id must be >= 0");
+    }
+    SearchServer& shard = shards_[GetShardIndex(document_id)];
+    shard.AddDocument(document_id, document, status, ratings);
+    statistics_->AddDocument(shard.GetWordFrequencies(document_id));
+}
+
+std::vector<std::exception_ptr> ShardedSearchServer::AddDocuments(const std::vector<NewDocument>& documents) {
+    std::vector<std::exception_ptr> errors(documents.size());
+    std::vector<std::vector<NewDocument>> shard_documents(shards_.size());
+    std::vector<std::vector<size_t>> shard_indexes(shards_.size());
+    for (size_t i = 0; i < documents.size(); ++i) {
+        if (documents[i].id < 0) {
+            errors[i] = std::make_exception_ptr(std::invalid_argument("document_id must be >= 0"));
+            continue;
+        }
+        const size_t shard = GetShardIndex(documents[i].id);
+        shard_documents[shard].push_back(documents[i]);
+        shard_indexes[shard].push_back(i);
+    }
+
+    std::vector<std::vector<std::exception_ptr>> shard_errors(shards_.size());
+    ForEachShard([this, &shard_errors, &shard_documents](const SearchServer&, size_t shard) {
+        shard_errors[shard] = shards_[shard].AddDocuments(pool_->GetPolicy(), shard_documents[shard]);
+    });
+
+    for (size_t shard = 0; shard < shards_.size(); ++shard) {
+        for (size_t i = 0; i < shard_indexes[shard].size(); ++i) {
+            errors[shard_indexes[shard][i]] = shard_errors[shard][i];
+            if (!shard_errors[shard][i]) {
+                statistics_->AddDocument(shards_[shard].GetWordFrequencies(shard_documents[shard][i].id));
+            }
+        }
+    }
+    return errors;
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+    if (document_id < 0) {
+        return;
+    }
+    SearchServer& shard = shards_[GetShardIndex(document_id)];
+    try {
+        statistics_->RemoveDocument(shard.GetWordFrequencies(document_id));
+    }
+    catch (const std::invalid_argument&) {
+        return;
+    }
+    shard.RemoveDocument(document_id);
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status, size_t max_count, QueryEvaluation evaluation) const {
+    return FindTopDocuments(raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
+        return document_status == status;
+    }, max_count, evaluation);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    if (document_id < 0) {
+        throw std::invalid_argument("document_id out of range"s);
+    }
+    return shards_[GetShardIndex(document_id)].MatchDocument(raw_query, document_id);
+}
+
+int ShardedSearchServer::GetDocumentCount() const noexcept {
+    return statistics_->GetDocumentCount();
+}
+
+size_t ShardedSearchServer::GetShardCount() const noexcept {
+    return shards_.size();
+}
+
+const SearchServer& ShardedSearchServer::GetShard(size_t index) const {
+    return shards_.at(index);
+}
+
+size_t ShardedSearchServer::GetDefaultWorkerCount(size_t shard_count) {
+    // A pool always has a worker, even when the calling thread could take every shard.
+    const size_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(shard_count, hardware_threads) - 1);
+}
+
+void ShardedSearchServer::LinkShards() {
+    for (SearchServer& shard : shards_) {
+        shard.SetCorpusStatistics(statistics_.get());
+    }
+}
+
+size_t ShardedSearchServer::GetShardIndex(int document_id) const {
+    return static_cast<size_t>(document_id) % shards_.size();
+}
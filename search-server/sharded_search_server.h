@@ -0,0 +1,96 @@
+#pragma once
+
+#include "corpus_statistics.h"
+#include "search_server.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+// Splits documents by id across several SearchServer shards of this process. Queries run
+// on all shards in parallel on the server's own ThreadPool and their tops are merged; the
+// shards share one table of document frequencies, so results are the same as those of a
+// single server with all documents.
+class ShardedSearchServer {
+public:
+    // worker_count 0 starts one worker per shard beyond the first, as the calling thread
+    // takes a shard itself, but no more than one per hardware thread.
+    template <typename StringContainer>
+    ShardedSearchServer(const StringContainer& stop_words, size_t shard_count, size_t worker_count = 0);
+    ShardedSearchServer(const std::string& stop_words_text, size_t shard_count, size_t worker_count = 0);
+    ShardedSearchServer(std::string_view stop_words_text, size_t shard_count, size_t worker_count = 0);
+
+    ShardedSearchServer(const ShardedSearchServer&) = delete;
+    ShardedSearchServer& operator=(const ShardedSearchServer&) = delete;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    std::vector<std::exception_ptr> AddDocuments(const std::vector<NewDocument>& documents);
+    void RemoveDocument(int document_id);
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count = MAX_RESULT_DOCUMENT_COUNT, QueryEvaluation evaluation = QueryEvaluation::EXHAUSTIVE) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status = DocumentStatus::ACTUAL, size_t max_count = MAX_RESULT_DOCUMENT_COUNT, QueryEvaluation evaluation = QueryEvaluation::EXHAUSTIVE) const;
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
+
+    int GetDocumentCount() const noexcept;
+    size_t GetShardCount() const noexcept;
+    const SearchServer& GetShard(size_t index) const;
+
+private:
+    static size_t GetDefaultWorkerCount(size_t shard_count);
+    void LinkShards();
+    size_t GetShardIndex(int document_id) const;
+
+    // Runs function on every shard in parallel; the first exception thrown is rethrown.
+    template <typename Function>
+    void ForEachShard(Function function) const;
+
+    std::unique_ptr<CorpusStatistics> statistics_;
+    // A deque, since SearchServer cannot be relocated.
+    std::deque<SearchServer> shards_;
+    std::unique_ptr<ThreadPool> pool_;
+};
+
+template <typename StringContainer>
+ShardedSearchServer::ShardedSearchServer(const StringContainer& stop_words, size_t shard_count, size_t worker_count)
+    : statistics_(std::make_unique<CorpusStatistics>()) {
+    if (shard_count == 0) {
+        throw std::invalid_argument("shard count must be positive"s);
+    }
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.emplace_back(stop_words);
+    }
+    pool_ = std::make_unique<ThreadPool>(worker_count == 0 ? GetDefaultWorkerCount(shard_count) : worker_count);
+    LinkShards();
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate, size_t max_count, QueryEvaluation evaluation) const {
+    std::vector<std::vector<Document>> shard_results(shards_.size());
+    ForEachShard([&](const SearchServer& shard, size_t index) {
+        shard_results[index] = shard.FindTopDocuments(raw_query, document_predicate, max_count, evaluation);
+    });
+
+    TopDocuments top_documents(max_count);
+    for (const std::vector<Document>& documents : shard_results) {
+        for (const Document& document : documents) {
+            top_documents.Push(document);
+        }
+    }
+    return top_documents.Build();
+}
+
+template <typename Function>
+void ShardedSearchServer::ForEachShard(Function function) const {
+    pool_->ParallelFor(shards_.size(), [this, &function](size_t index) {
+        function(shards_[index], index);
+    });
+}
@@ -0,0 +1,47 @@
+#include "snapshot.h"
+
+SnapshotWriter::SnapshotWriter(std::ostream& output) : output_(output) {}
+
+void SnapshotWriter::WriteHeader() {
+    WriteBytes(SNAPSHOT_MAGIC.data(), SNAPSHOT_MAGIC.size());
+    Write<uint32_t>(SNAPSHOT_VERSION);
+}
+
+void SnapshotWriter::WriteString(std::string_view text) {
+    Write<uint64_t>(text.size());
+    WriteBytes(text.data(), text.size());
+}
+
+void SnapshotWriter::WriteBytes(const void* data, size_t size) {
+    output_.write(static_cast<const char*>(data), size);
+    position_ += size;
+}
+
+SnapshotReader::SnapshotReader(std::string_view data) : data_(data), begin_(data.data()) {}
+
+void SnapshotReader::ReadHeader() {
+    if (std::string_view(Take(SNAPSHOT_MAGIC.size()), SNAPSHOT_MAGIC.size()) != SNAPSHOT_MAGIC) {
+        throw std::runtime_error("not a search server snapshot");
+    }
+    if (Read<uint32_t>() != SNAPSHOT_VERSION) {
+        throw std::runtime_error("unsupported snapshot version");
+    }
+}
+
+std::string_view SnapshotReader::ReadString() {
+    const uint64_t size = Read<uint64_t>();
+    return { Take(size), size };
+}
+
+const char* SnapshotReader::Take(size_t size) {
+    if (size > data_.size()) {
+        throw std::runtime_error("snapshot is truncated");
+    }
+    const char* position = data_.data();
+    data_.remove_prefix(size);
+    return position;
+}
+
+void SnapshotReader::SkipPadding() {
+    Take((8 - (data_.data() - begin_) % 8) % 8);
+}
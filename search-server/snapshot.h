@@ -0,0 +1,152 @@
+#pragma once
+
+#include "array_view.h"
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Snapshot layout, all values in host byte order:
+//   header      SNAPSHOT_MAGIC, uint32 SNAPSHOT_VERSION
+//   stop words  uint64 count, then strings
+//   documents   SnapshotDocumentRecord[] (ascending ids)
+//   texts       char[] holding every document text
+//   forward     {uint32 term id, uint32 term count}[], each document's run sorted by term
+//               id; a term id is the term's position in the dictionary plus the first
+//               mapped term id of InvertedIndex
+//   dictionary  SnapshotTermRecord[] (ascending terms)
+//   terms       char[] holding every term
+//   postings    {int32 document id, uint32 term count}[], each term's run sorted by id
+// Strings are prefixed with their uint64 length. Arrays are prefixed with their uint64
+// length too, padded so that the values start at a multiple of 8 bytes; a mapped
+// snapshot is read in place.
+inline constexpr std::string_view SNAPSHOT_MAGIC = "SRCHSNAP";
+inline constexpr uint32_t SNAPSHOT_VERSION = 3;
+
+struct SnapshotDocumentRecord {
+    int32_t id;
+    int32_t rating;
+    int32_t status;
+    uint32_t length;
+    uint64_t text_offset;
+    uint64_t text_size;
+    uint64_t forward_offset;
+    uint64_t forward_size;
+};
+
+struct SnapshotTermRecord {
+    uint64_t term_offset;
+    uint64_t postings_offset;
+    uint32_t term_size;
+    uint32_t posting_count;
+};
+
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(std::ostream& output);
+
+    void WriteHeader();
+    void WriteString(std::string_view text);
+
+    template <typename Value>
+    void Write(Value value);
+
+    template <typename Value>
+    void WriteArray(const std::vector<Value>& values);
+
+    // Starts an array of size values, which follow in one or more WriteValues calls.
+    template <typename Value>
+    void BeginArray(uint64_t size);
+    template <typename Value>
+    void WriteValues(const Value* values, size_t count);
+
+private:
+    void WriteBytes(const void* data, size_t size);
+
+    std::ostream& output_;
+    uint64_t position_ = 0;
+};
+
+class SnapshotReader {
+public:
+    explicit SnapshotReader(std::string_view data);
+
+    void ReadHeader();
+    std::string_view ReadString();
+
+    template <typename Value>
+    Value Read();
+
+    template <typename Value>
+    std::vector<Value> ReadArray();
+
+    // The values of an array, in place; data must start at a multiple of 8 bytes.
+    template <typename Value>
+    ArrayView<Value> ViewArray();
+
+private:
+    const char* Take(size_t size);
+    // Skips the padding that WriteArray puts before an array.
+    void SkipPadding();
+
+    std::string_view data_;
+    const char* begin_;
+};
+
+template <typename Value>
+void SnapshotWriter::Write(Value value) {
+    static_assert(std::is_trivially_copyable_v<Value>);
+    WriteBytes(&value, sizeof(value));
+}
+
+template <typename Value>
+void SnapshotWriter::WriteArray(const std::vector<Value>& values) {
+    BeginArray<Value>(values.size());
+    WriteValues(values.data(), values.size());
+}
+
+template <typename Value>
+void SnapshotWriter::BeginArray(uint64_t size) {
+    static_assert(std::is_trivially_copyable_v<Value> && alignof(Value) <= 8);
+    static constexpr char PADDING[8] = {};
+    WriteBytes(PADDING, (8 - position_ % 8) % 8);
+    Write<uint64_t>(size);
+}
+
+template <typename Value>
+void SnapshotWriter::WriteValues(const Value* values, size_t count) {
+    WriteBytes(values, count * sizeof(Value));
+}
+
+template <typename Value>
+Value SnapshotReader::Read() {
+    static_assert(std::is_trivially_copyable_v<Value>);
+    Value value;
+    std::memcpy(&value, Take(sizeof(value)), sizeof(value));
+    return value;
+}
+
+template <typename Value>
+std::vector<Value> SnapshotReader::ReadArray() {
+    const ArrayView<Value> values = ViewArray<Value>();
+    return std::vector<Value>(values.begin(), values.end());
+}
+
+template <typename Value>
+ArrayView<Value> SnapshotReader::ViewArray() {
+    static_assert(std::is_trivially_copyable_v<Value> && alignof(Value) <= 8);
+    SkipPadding();
+    const uint64_t size = Read<uint64_t>();
+    if (size > data_.size() / sizeof(Value)) {
+        throw std::runtime_error("snapshot is truncated");
+    }
+    const char* data = Take(size * sizeof(Value));
+    if (reinterpret_cast<uintptr_t>(data) % alignof(Value) != 0) {
+        throw std::runtime_error("snapshot is not aligned");
+    }
+    return { reinterpret_cast<const Value*>(data), size };
+}
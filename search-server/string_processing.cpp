@@ -1,5 +1,134 @@
 #include "string_processing.h"
 
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define SEARCH_SERVER_X86_SIMD
+#endif
+
+namespace {
+
+constexpr size_t BLOCK_SIZE = 64;
+
+using ScanBlockFunction = void (*)(const char* block, uint64_t& space_mask, uint64_t& control_mask);
+
+void ScanBlockScalar(const char* block, uint64_t& space_mask, uint64_t& control_mask) {
+    space_mask = 0;
+    control_mask = 0;
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        const auto c = static_cast<unsigned char>(block[i]);
+        space_mask |= static_cast<uint64_t>(c == ' ') << i;
+        control_mask |= static_cast<uint64_t>(c < ' ') << i;
+    }
+}
+
+#ifdef SEARCH_SERVER_X86_SIMD
+
+void ScanBlockSse2(const char* block, uint64_t& space_mask, uint64_t& control_mask) {
+    const __m128i spaces = _mm_set1_epi8(' ');
+    const __m128i last_control = _mm_set1_epi8(' ' - 1);
+    space_mask = 0;
+    control_mask = 0;
+    for (size_t i = 0; i < BLOCK_SIZE; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+        const __m128i is_control = _mm_cmpeq_epi8(_mm_min_epu8(bytes, last_control), bytes);
+        space_mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, spaces)))) << i;
+        control_mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(is_control))) << i;
+    }
+}
+
+__attribute__((target("avx2")))
+void ScanBlockAvx2(const char* block, uint64_t& space_mask, uint64_t& control_mask) {
+    const __m256i spaces = _mm256_set1_epi8(' ');
+    const __m256i last_control = _mm256_set1_epi8(' ' - 1);
+    space_mask = 0;
+    control_mask = 0;
+    for (size_t i = 0; i < BLOCK_SIZE; i += 32) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+        const __m256i is_control = _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, last_control), bytes);
+        space_mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, spaces)))) << i;
+        control_mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(is_control))) << i;
+    }
+}
+
+ScanBlockFunction SelectScanBlock() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return ScanBlockAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return ScanBlockSse2;
+    }
+    return ScanBlockScalar;
+}
+
+#else
+
+ScanBlockFunction SelectScanBlock() {
+    return ScanBlockScalar;
+}
+
+#endif
+
+const ScanBlockFunction scan_block = SelectScanBlock();
+
+}
+
+WordTokenizer::WordTokenizer(std::string_view text)
+    : text_(text) {
+}
+
+bool WordTokenizer::Next(std::string_view& word, bool& is_valid) {
+    while (true) {
+        if (space_mask_ != 0) {
+            const int space_bit = __builtin_ctzll(space_mask_);
+            const uint64_t before_space = (uint64_t{1} << space_bit) - 1;
+            word_has_control_ |= (control_mask_ & before_space) != 0;
+            control_mask_ &= ~before_space;
+            space_mask_ &= space_mask_ - 1;
+
+            const size_t word_end = block_begin_ + space_bit;
+            word = text_.substr(word_begin_, word_end - word_begin_);
+            is_valid = !word_has_control_;
+            word_begin_ = word_end + 1;
+            word_has_control_ = false;
+            return true;
+        }
+
+        word_has_control_ |= control_mask_ != 0;
+        control_mask_ = 0;
+        if (next_block_ >= text_.size()) {
+            break;
+        }
+        ScanNextBlock();
+    }
+
+    if (word_begin_ >= text_.size()) {
+        return false;
+    }
+    word = text_.substr(word_begin_);
+    is_valid = !word_has_control_;
+    word_begin_ = text_.size();
+    return true;
+}
+
+void WordTokenizer::ScanNextBlock() {
+    block_begin_ = next_block_;
+    next_block_ += BLOCK_SIZE;
+
+    const size_t remaining = text_.size() - block_begin_;
+    if (remaining >= BLOCK_SIZE) {
+        scan_block(text_.data() + block_begin_, space_mask_, control_mask_);
+        return;
+    }
+
+    char tail[BLOCK_SIZE];
+    std::memset(tail, 'a', BLOCK_SIZE);
+    std::memcpy(tail, text_.data() + block_begin_, remaining);
+    scan_block(tail, space_mask_, control_mask_);
+}
+
 std::vector<std::string> SplitIntoWords(const std::string& text) {
     std::vector<std::string> words;
     std::string word;
@@ -22,10 +151,8 @@ std::vector<std::string> SplitIntoWords(const std::string& text) {
 
 std::vector<std::string_view> SplitIntoWordsView(std::string_view str) {
     std::vector<std::string_view> words;
-    while (!str.empty()) {
-        const size_t space_pos = str.find(' ');
-        words.push_back(str.substr(0, space_pos));
-        str.remove_prefix(space_pos != str.npos ? space_pos + 1 : str.size());
-    }
+    ForEachWordView(str, [&words](std::string_view word) {
+        words.push_back(word);
+    });
     return words;
-}
\ No newline at end of file
+}
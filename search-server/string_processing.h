@@ -1,13 +1,46 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <set>
+#include <string_view>
+
+// Splits text on single spaces exactly like SplitIntoWordsView and tells for every word
+// whether it is free of control characters. The text is scanned once, 64 bytes at a time,
+// with the widest instruction set the CPU supports (AVX2, SSE2 or plain C++).
+class WordTokenizer {
+public:
+    explicit WordTokenizer(std::string_view text);
+
+    bool Next(std::string_view& word, bool& is_valid);
+
+private:
+    void ScanNextBlock();
+
+    std::string_view text_;
+    size_t block_begin_ = 0;
+    size_t next_block_ = 0;
+    uint64_t space_mask_ = 0;
+    uint64_t control_mask_ = 0;
+    size_t word_begin_ = 0;
+    bool word_has_control_ = false;
+};
 
 std::vector<std::string> SplitIntoWords(const std::string& text);
 
 std::vector<std::string_view> SplitIntoWordsView(std::string_view str);
 
+template <typename Callback>
+void ForEachWordView(std::string_view str, Callback callback) {
+    WordTokenizer tokenizer(str);
+    std::string_view word;
+    bool is_valid = true;
+    while (tokenizer.Next(word, is_valid)) {
+        callback(word);
+    }
+}
+
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
     std::set<std::string, std::less<>> non_empty_strings;
@@ -17,4 +50,4 @@ std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContain
         }
     }
     return non_empty_strings;
-}
\ No newline at end of file
+}
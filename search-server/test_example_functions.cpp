@@ -9,6 +9,21 @@ void AddDocument(SearchServer& search_server, int document_id, const std::string
     }
 }
 
+void AddDocuments(SearchServer& search_server, const std::vector<NewDocument>& documents) {
+    const auto errors = search_server.AddDocuments(std::execution::par, documents);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        if (!errors[i]) {
+            continue;
+        }
+        try {
+            std::rethrow_exception(errors[i]);
+        }
+        catch (const std::exception& e) {
+            std::cout << "Error adding document "s << documents[i].id << ": "s << e.what() << std::endl;
+        }
+    }
+}
+
 void FindTopDocuments(const SearchServer& search_server, const std::string& raw_query) {
     std::cout << "Error adding document "s << raw_query << std::endl;
     try {
@@ -24,9 +39,10 @@ void FindTopDocuments(const SearchServer& search_server, const std::string& raw_
 void MatchDocuments(const SearchServer& search_server, const std::string& query) {
     try {
         std::cout << "Matching documents for query "s << query << std::endl;
-        for (const int document_id : search_server) {
-            const auto [words, status] = search_server.MatchDocument(query, document_id);
-            PrintMatchDocumentResult(document_id, words, status);
+        const std::vector<int> document_ids(search_server.begin(), search_server.end());
+        const DocumentMatches matches = search_server.MatchDocuments(std::execution::par, query, document_ids);
+        for (size_t i = 0; i < matches.size(); ++i) {
+            PrintMatchDocumentResult(matches.GetDocumentId(i), matches.GetWords(i), matches.GetStatus(i));
         }
     }
     catch (const std::exception& e) {
@@ -42,6 +58,10 @@ void PrintDocument(const Document& document) {
 }
 
 void PrintMatchDocumentResult(int document_id, const std::vector<std::string_view>& words, DocumentStatus status) {
+    PrintMatchDocumentResult(document_id, DocumentMatches::WordRange(words.begin(), words.end()), status);
+}
+
+void PrintMatchDocumentResult(int document_id, const DocumentMatches::WordRange& words, DocumentStatus status) {
     std::cout << "{ "s
         << "document_id = "s << document_id << ", "s
         << "status = "s << static_cast<int>(status) << ", "s
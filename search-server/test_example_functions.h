@@ -4,6 +4,8 @@
 
 void AddDocument(SearchServer& search_server, int document_id, const std::string& document, DocumentStatus status, const std::vector<int>& ratings);
 
+void AddDocuments(SearchServer& search_server, const std::vector<NewDocument>& documents);
+
 void FindTopDocuments(const SearchServer& search_server, const std::string& raw_query);
 
 void MatchDocuments(const SearchServer& search_server, const std::string& query);
@@ -11,3 +13,4 @@ void MatchDocuments(const SearchServer& search_server, const std::string& query)
 void PrintDocument(const Document& document);
 
 void PrintMatchDocumentResult(int document_id, const std::vector<std::string_view>& words, DocumentStatus status);
+void PrintMatchDocumentResult(int document_id, const DocumentMatches::WordRange& words, DocumentStatus status);
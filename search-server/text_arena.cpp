@@ -0,0 +1,32 @@
+#include "text_arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+std::string_view TextArena::Store(std::string_view text) {
+    if (text.empty()) {
+        return {};
+    }
+    if (text.size() > capacity_ - used_) {
+        const size_t chunk_size = std::max(CHUNK_SIZE, text.size());
+        chunks_.push_back(std::make_unique<char[]>(chunk_size));
+        chunk_sizes_.push_back(chunk_size);
+        used_ = 0;
+        capacity_ = chunk_size;
+    }
+
+    char* position = chunks_.back().get() + used_;
+    std::memcpy(position, text.data(), text.size());
+    used_ += text.size();
+    return { position, text.size() };
+}
+
+size_t TextArena::GetMemoryUsage() const noexcept {
+    size_t bytes = sizeof(*this);
+    bytes += chunks_.capacity() * sizeof(std::unique_ptr<char[]>);
+    bytes += chunk_sizes_.capacity() * sizeof(size_t);
+    for (const size_t chunk_size : chunk_sizes_) {
+        bytes += chunk_size;
+    }
+    return bytes;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Append-only storage for document texts. Texts are packed into large chunks instead of
+// one heap string per document; space of removed texts comes back only when the arena
+// is rebuilt.
+class TextArena {
+public:
+    std::string_view Store(std::string_view text);
+
+    size_t GetMemoryUsage() const noexcept;
+
+private:
+    static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    std::vector<size_t> chunk_sizes_;
+    size_t used_ = 0;
+    size_t capacity_ = 0;
+};
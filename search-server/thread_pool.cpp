@@ -0,0 +1,226 @@
+#include "thread_pool.h"
+
+#include "config.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+
+namespace {
+
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+}
+
+struct ThreadPool::SubmittedTask {
+    Loop loop;
+    std::function<void()> function;
+};
+
+ThreadPool::ThreadPool(size_t worker_count, bool pin_workers) {
+    if (worker_count == 0) {
+        worker_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i <= worker_count; ++i) {
+        queues_.emplace_back();
+    }
+    workers_.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers_.emplace_back([this, i] {
+            WorkerLoop(i);
+        });
+    }
+    if (pin_workers) {
+        PinWorkers();
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_up_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::GetWorkerCount() const noexcept {
+    return workers_.size();
+}
+
+PoolPolicy ThreadPool::GetPolicy() noexcept {
+    return { *this };
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    auto* submitted = new SubmittedTask{ {}, std::move(task) };
+    submitted->loop.run = [](void* submitted, size_t begin, size_t end) {
+        static_cast<SubmittedTask*>(submitted)->function();
+    };
+    submitted->loop.function = submitted;
+    submitted->loop.release = [](Loop& loop) {
+        delete static_cast<SubmittedTask*>(loop.function);
+    };
+    {
+        TaskQueue& queue = queues_[GetQueueIndex()];
+        std::lock_guard lock(queue.mutex);
+        queue.tasks.push_back({ &submitted->loop, 0, 1 });
+        queued_task_count_.fetch_add(1, std::memory_order_release);
+    }
+    WakeWorkers();
+}
+
+void ThreadPool::Run(Loop& loop, size_t count) {
+    const size_t task_count = std::min(count, (workers_.size() + 1) * TASKS_PER_WORKER);
+    if (task_count == 1) {
+        loop.run(loop.function, 0, count);
+        return;
+    }
+
+    // The first chunk is kept for the calling thread; the rest go to its own deque, where
+    // idle workers steal them from the front.
+    const size_t queue_index = GetQueueIndex();
+    loop.pending.store(task_count, std::memory_order_relaxed);
+    {
+        TaskQueue& queue = queues_[queue_index];
+        std::lock_guard lock(queue.mutex);
+        for (size_t i = task_count - 1; i > 0; --i) {
+            queue.tasks.push_back({ &loop, count * i / task_count, count * (i + 1) / task_count });
+        }
+        queued_task_count_.fetch_add(task_count - 1, std::memory_order_release);
+    }
+    WakeWorkers();
+
+    Execute({ &loop, 0, count / task_count });
+    while (loop.pending.load(std::memory_order_acquire) != 0) {
+        if (!TryRunOwnTask(queue_index, loop)) {
+            std::this_thread::yield();
+        }
+    }
+    if (loop.error) {
+        std::rethrow_exception(loop.error);
+    }
+}
+
+bool ThreadPool::TryRunTask(size_t queue_index) {
+    if (queued_task_count_.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+    Task task;
+    bool found = TryPop(queues_[queue_index], true, task);
+    for (size_t i = 1; !found && i < queues_.size(); ++i) {
+        found = TryPop(queues_[(queue_index + i) % queues_.size()], false, task);
+    }
+    if (found) {
+        Execute(task);
+    }
+    return found;
+}
+
+bool ThreadPool::TryRunOwnTask(size_t queue_index, const Loop& loop) {
+    TaskQueue& queue = queues_[queue_index];
+    Task task;
+    {
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty() || queue.tasks.back().loop != &loop) {
+            return false;
+        }
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        queued_task_count_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    Execute(task);
+    return true;
+}
+
+bool ThreadPool::TryPop(TaskQueue& queue, bool from_back, Task& task) {
+    std::lock_guard lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    if (from_back) {
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+    }
+    else {
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+    }
+    queued_task_count_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+void ThreadPool::Execute(const Task& task) {
+    Loop& loop = *task.loop;
+    try {
+        loop.run(loop.function, task.begin, task.end);
+    }
+    catch (...) {
+        std::lock_guard lock(loop.error_mutex);
+        if (!loop.error) {
+            loop.error = std::current_exception();
+        }
+    }
+    if (loop.release != nullptr) {
+        loop.release(loop);
+        return;
+    }
+    // The caller may return as soon as pending drops to zero, so loop is not touched after.
+    loop.pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void ThreadPool::WakeWorkers() {
+    // Sleeping workers test the task count under sleep_mutex_, so taking it here means
+    // none of them can miss the notification.
+    {
+        std::lock_guard lock(sleep_mutex_);
+    }
+    wake_up_.notify_all();
+}
+
+void ThreadPool::WorkerLoop(size_t worker_index) {
+    current_pool = this;
+    current_worker = worker_index;
+    while (true) {
+        if (TryRunTask(worker_index)) {
+            continue;
+        }
+        std::unique_lock lock(sleep_mutex_);
+        wake_up_.wait(lock, [this] {
+            return stopping_ || queued_task_count_.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping_ && queued_task_count_.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::PinWorkers() {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return;
+    }
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed)) {
+            cpus.push_back(cpu);
+        }
+    }
+    for (size_t i = 0; i < workers_.size() && !cpus.empty(); ++i) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpus[i % cpus.size()], &cpu_set);
+        pthread_setaffinity_np(workers_[i].native_handle(), sizeof(cpu_set), &cpu_set);
+    }
+#endif
+}
+
+size_t ThreadPool::GetQueueIndex() const noexcept {
+    return current_pool == this ? current_worker : workers_.size();
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool;
+
+// Execution policy that runs the parallel algorithms of the search server on a ThreadPool
+// instead of the TBB backend of std::execution::par.
+struct PoolPolicy {
+    ThreadPool& pool;
+};
+
+// Fixed set of workers with one task deque each. A worker pops its own tasks LIFO and
+// steals the oldest tasks of other workers when it runs dry. A thread waiting for its
+// parallel loop runs the loop's remaining tasks itself, so loops nested inside pool tasks
+// reuse the same workers instead of starting more threads. It never picks up unrelated
+// tasks while waiting, which keeps per-thread query state of the waiting call intact.
+class ThreadPool {
+public:
+    // worker_count 0 starts one worker per hardware thread. With pin_workers, worker i is
+    // bound to the i-th CPU the process may run on, so consecutive workers share a node.
+    explicit ThreadPool(size_t worker_count = 0, bool pin_workers = false);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t GetWorkerCount() const noexcept;
+    PoolPolicy GetPolicy() noexcept;
+
+    // Calls function(i) for every i in [0, count) and returns once all calls finished.
+    // The calling thread takes part; the first exception thrown is rethrown.
+    template <typename Function>
+    void ParallelFor(size_t count, Function function);
+
+    // Queues task to run on a worker and returns at once. Exceptions thrown by the task
+    // are dropped, so it should report its outcome itself, e.g. through a promise. Tasks
+    // still queued when the pool is destroyed are run first.
+    void Submit(std::function<void()> task);
+
+private:
+    // State of one ParallelFor call, living on the stack of its caller, or of a submitted
+    // task, which is freed by release once it has run.
+    struct Loop {
+        void (*run)(void* function, size_t begin, size_t end);
+        void* function;
+        void (*release)(Loop& loop) = nullptr;
+        std::atomic<size_t> pending{ 0 };
+        std::mutex error_mutex;
+        std::exception_ptr error;
+    };
+
+    struct Task {
+        Loop* loop;
+        size_t begin;
+        size_t end;
+    };
+
+    struct SubmittedTask;
+
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void Run(Loop& loop, size_t count);
+    bool TryRunTask(size_t queue_index);
+    // Runs the newest task of the thread's own deque if it belongs to loop.
+    bool TryRunOwnTask(size_t queue_index, const Loop& loop);
+    bool TryPop(TaskQueue& queue, bool from_back, Task& task);
+    static void Execute(const Task& task);
+    void WakeWorkers();
+    void WorkerLoop(size_t worker_index);
+    void PinWorkers();
+    // Index of the deque owned by the current thread; external threads share the last one.
+    size_t GetQueueIndex() const noexcept;
+
+    // One deque per worker plus one for tasks submitted from outside the pool.
+    std::deque<TaskQueue> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> queued_task_count_{ 0 };
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_up_;
+    bool stopping_ = false;
+};
+
+template <typename Function>
+void ThreadPool::ParallelFor(size_t count, Function function) {
+    if (count == 0) {
+        return;
+    }
+    Loop loop;
+    loop.run = [](void* function, size_t begin, size_t end) {
+        Function& body = *static_cast<Function*>(function);
+        for (size_t i = begin; i < end; ++i) {
+            body(i);
+        }
+    };
+    loop.function = &function;
+    Run(loop, count);
+}
@@ -0,0 +1,71 @@
+#include "top_documents.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "config.h"
+
+bool IsMoreRelevant(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < EPS) {
+        if (lhs.rating != rhs.rating) {
+            return lhs.rating > rhs.rating;
+        }
+        return lhs.id < rhs.id;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+TopDocuments::TopDocuments(size_t max_count) : max_count_(max_count) {
+    heap_.reserve(max_count_);
+}
+
+void TopDocuments::Reset(size_t max_count) {
+    max_count_ = max_count;
+    heap_.clear();
+    heap_.reserve(max_count_);
+}
+
+void TopDocuments::Push(const Document& document) {
+    if (heap_.size() < max_count_) {
+        heap_.push_back(document);
+        std::push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+    }
+    else if (max_count_ > 0 && IsMoreRelevant(document, heap_.front())) {
+        std::pop_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+        heap_.back() = document;
+        std::push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+    }
+}
+
+void TopDocuments::Merge(const TopDocuments& other) {
+    for (const Document& document : other.heap_) {
+        Push(document);
+    }
+}
+
+size_t TopDocuments::GetMaxCount() const noexcept {
+    return max_count_;
+}
+
+bool TopDocuments::IsFull() const noexcept {
+    return heap_.size() >= max_count_;
+}
+
+const Document& TopDocuments::GetWorst() const {
+    return heap_.front();
+}
+
+bool TopDocuments::MayAccept(double max_relevance) const {
+    if (max_count_ == 0) {
+        return false;
+    }
+    // A document within EPS of the worst kept one is ranked by rating and may still get in;
+    // the second EPS covers rounding between an upper bound and the exact relevance sum.
+    return !IsFull() || max_relevance > GetWorst().relevance - 2 * EPS;
+}
+
+std::vector<Document> TopDocuments::Build() const {
+    std::vector<Document> documents(heap_);
+    std::sort_heap(documents.begin(), documents.end(), IsMoreRelevant);
+    return documents;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "document.h"
+
+#include <cstddef>
+#include <vector>
+
+bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+
+class TopDocuments {
+public:
+    explicit TopDocuments(size_t max_count);
+
+    // Empties the top and sets a new limit, keeping the allocated storage.
+    void Reset(size_t max_count);
+    void Push(const Document& document);
+    void Merge(const TopDocuments& other);
+
+    size_t GetMaxCount() const noexcept;
+    bool IsFull() const noexcept;
+    const Document& GetWorst() const;
+    bool MayAccept(double max_relevance) const;
+
+    std::vector<Document> Build() const;
+
+private:
+    size_t max_count_;
+    // Heap ordered by IsMoreRelevant, so the front holds the least relevant document kept.
+    std::vector<Document> heap_;
+};
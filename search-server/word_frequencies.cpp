@@ -0,0 +1,93 @@
+#include "word_frequencies.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+WordFrequencies::Iterator::Iterator(const InvertedIndex* index, const InvertedIndex::TermFrequency* const* position, uint32_t document_length)
+    : index_(index)
+    , position_(position)
+    , document_length_(document_length) {
+}
+
+WordFrequencies::Iterator::value_type WordFrequencies::Iterator::operator*() const {
+    const InvertedIndex::TermFrequency& entry = **position_;
+    return { index_->GetTerm(entry.term_id), ComputeTermFreq(entry.term_count, document_length_) };
+}
+
+WordFrequencies::Iterator& WordFrequencies::Iterator::operator++() {
+    ++position_;
+    return *this;
+}
+
+WordFrequencies::Iterator WordFrequencies::Iterator::operator++(int) {
+    Iterator old = *this;
+    ++position_;
+    return old;
+}
+
+bool WordFrequencies::Iterator::operator==(const Iterator& other) const noexcept {
+    return position_ == other.position_;
+}
+
+bool WordFrequencies::Iterator::operator!=(const Iterator& other) const noexcept {
+    return position_ != other.position_;
+}
+
+WordFrequencies::WordFrequencies(const InvertedIndex& index, ArrayView<InvertedIndex::TermFrequency> term_freqs, uint32_t document_length)
+    : index_(&index)
+    , term_freqs_(term_freqs)
+    , document_length_(document_length) {
+}
+
+WordFrequencies::Iterator WordFrequencies::begin() const {
+    SortWords();
+    return Iterator(index_, word_order_.data(), document_length_);
+}
+
+WordFrequencies::Iterator WordFrequencies::end() const {
+    SortWords();
+    return Iterator(index_, word_order_.data() + word_order_.size(), document_length_);
+}
+
+size_t WordFrequencies::size() const noexcept {
+    return term_freqs_.size();
+}
+
+bool WordFrequencies::empty() const noexcept {
+    return term_freqs_.empty();
+}
+
+size_t WordFrequencies::count(std::string_view word) const {
+    return Find(word) != nullptr ? 1 : 0;
+}
+
+double WordFrequencies::at(std::string_view word) const {
+    const InvertedIndex::TermFrequency* entry = Find(word);
+    if (entry == nullptr) {
+        throw std::out_of_range("word is not in the document"s);
+    }
+    return ComputeTermFreq(entry->term_count, document_length_);
+}
+
+const InvertedIndex::TermFrequency* WordFrequencies::Find(std::string_view word) const {
+    const InvertedIndex::TermId term_id = index_->FindTermId(word);
+    const auto it = std::lower_bound(term_freqs_.begin(), term_freqs_.end(), term_id, [](const InvertedIndex::TermFrequency& entry, InvertedIndex::TermId id) {
+        return entry.term_id < id;
+    });
+    return it != term_freqs_.end() && it->term_id == term_id ? &*it : nullptr;
+}
+
+void WordFrequencies::SortWords() const {
+    if (word_order_.size() == term_freqs_.size()) {
+        return;
+    }
+    word_order_.reserve(term_freqs_.size());
+    for (const InvertedIndex::TermFrequency& entry : term_freqs_) {
+        word_order_.push_back(&entry);
+    }
+    std::sort(word_order_.begin(), word_order_.end(), [this](const InvertedIndex::TermFrequency* lhs, const InvertedIndex::TermFrequency* rhs) {
+        return index_->GetTerm(lhs->term_id) < index_->GetTerm(rhs->term_id);
+    });
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "array_view.h"
+#include "inverted_index.h"
+
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Read-only view of a document's forward index that presents it keyed by words.
+// Iterators visit words in lexicographic order, like the std::map the view replaced; the
+// order is sorted on the first call to begin() or end(), so a view only looked up with
+// count and at, or walked with ForEachWord, costs nothing to make. The first iteration
+// must not race with another one of the same view. The view is valid until the document
+// is removed or the server is compacted.
+class WordFrequencies {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator(const InvertedIndex* index, const InvertedIndex::TermFrequency* const* position, uint32_t document_length);
+
+        value_type operator*() const;
+        Iterator& operator++();
+        Iterator operator++(int);
+        bool operator==(const Iterator& other) const noexcept;
+        bool operator!=(const Iterator& other) const noexcept;
+
+    private:
+        const InvertedIndex* index_;
+        const InvertedIndex::TermFrequency* const* position_;
+        uint32_t document_length_;
+    };
+
+    WordFrequencies(const InvertedIndex& index, ArrayView<InvertedIndex::TermFrequency> term_freqs, uint32_t document_length);
+
+    Iterator begin() const;
+    Iterator end() const;
+    size_t size() const noexcept;
+    bool empty() const noexcept;
+
+    size_t count(std::string_view word) const;
+    // Throws std::out_of_range if the document does not contain word.
+    double at(std::string_view word) const;
+
+    // Calls function(word, term_freq) for every word of the document in term id order,
+    // which costs no sorting.
+    template <typename Function>
+    void ForEachWord(Function function) const;
+
+private:
+    const InvertedIndex::TermFrequency* Find(std::string_view word) const;
+    void SortWords() const;
+
+    const InvertedIndex* index_;
+    ArrayView<InvertedIndex::TermFrequency> term_freqs_;
+    // Entries of term_freqs_ sorted by their words; empty until first iterated.
+    mutable std::vector<const InvertedIndex::TermFrequency*> word_order_;
+    uint32_t document_length_;
+};
+
+template <typename Function>
+void WordFrequencies::ForEachWord(Function function) const {
+    for (const InvertedIndex::TermFrequency& entry : term_freqs_) {
+        function(index_->GetTerm(entry.term_id), ComputeTermFreq(entry.term_count, document_length_));
+    }
+}